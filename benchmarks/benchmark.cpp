@@ -0,0 +1,339 @@
+#include <malloc.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "automaton.hpp"
+#include "batch_runner.hpp"
+#include "dense_dfa.hpp"
+#include "parallel_scanner.hpp"
+#include "suffix_query.hpp"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// Bytes held through operator new. The peak is reset before a stage, so that
+// it tells the memory of that stage alone.
+std::atomic<size_t> live_bytes{0};
+std::atomic<size_t> peak_live_bytes{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  void* pointer = std::malloc(size == 0 ? 1 : size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  const size_t bytes = malloc_usable_size(pointer);
+  const size_t live =
+      live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  size_t peak = peak_live_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !peak_live_bytes.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
+  return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+  if (pointer != nullptr) {
+    live_bytes.fetch_sub(malloc_usable_size(pointer),
+                         std::memory_order_relaxed);
+    std::free(pointer);
+  }
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  operator delete(pointer);
+}
+
+namespace {
+
+enum class Stage {
+  kConstruct,
+  kRemoveEpsEdges,
+  kToDFA,
+  kToCDFA,
+  kToMCDFA,
+  kAdditionToMCDFA,
+  kIsSuffixByLetterFixLength,
+};
+
+struct Generator {
+  const char* name;
+  std::string (*regex)(size_t);
+  std::vector<int64_t> sizes;
+};
+
+struct StageInfo {
+  const char* name;
+  Stage stage;
+};
+
+// (((a*b)*c)*a ...)*
+std::string NestedStars(size_t depth) {
+  std::string regex = "a";
+  for (size_t i = 1; i < depth; ++i) {
+    regex += '*';
+    regex += "abc"[i % 3];
+    regex += '.';
+  }
+  return regex + "*";
+}
+
+// abcabc...
+std::string LongConcatenation(size_t length) {
+  std::string regex = "a";
+  for (size_t i = 1; i < length; ++i) {
+    regex += "abc"[i % 3];
+    regex += '.';
+  }
+  return regex;
+}
+
+// (l_1 + l_2 + ... + l_n)* with n different letters
+std::string UnionOfLetters(size_t count) {
+  static const std::string kLetters =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ023456789";
+  std::string regex(1, kLetters[0]);
+  for (size_t i = 1; i < count; ++i) {
+    regex += kLetters[i % kLetters.size()];
+    regex += '+';
+  }
+  return regex + "*";
+}
+
+// (a + b)*a(a + b)^n, the minimal automaton has 2^(n + 1) states
+std::string ExponentialBlowUp(size_t n) {
+  std::string regex = "ab+*a.";
+  for (size_t i = 0; i < n; ++i) {
+    regex += "ab+.";
+  }
+  return regex;
+}
+
+// Returns the bytes held before the stage.
+size_t ResetPeakBytes() {
+  const size_t live = live_bytes.load(std::memory_order_relaxed);
+  peak_live_bytes.store(live, std::memory_order_relaxed);
+  return live;
+}
+
+// The input of every stage is the output of the previous one. The stages
+// still rerun their prerequisites on it: ToCDFA calls ToDFA, which closes
+// over eps edges and determinizes again, and ToMCDFA calls ToCDFA. So the
+// times of ToDFA, ToCDFA, ToMCDFA and AdditionToMCDFA are cumulative, each
+// includes a pass of the stages before it over an input they leave as is.
+// IsSuffixByLetterFixLength is timed on a SuffixQuery of the prepared
+// automaton, as the method of Automaton would minimize it again.
+Automaton Prepare(const std::string& regex, Stage stage) {
+  Automaton automaton(regex);
+  switch (stage) {
+    case Stage::kConstruct:
+    case Stage::kRemoveEpsEdges:
+      break;
+    case Stage::kToDFA:
+      automaton.RemoveEpsEdges();
+      break;
+    case Stage::kToCDFA:
+      automaton.ToDFA();
+      break;
+    case Stage::kToMCDFA:
+      automaton.ToCDFA();
+      break;
+    case Stage::kAdditionToMCDFA:
+    case Stage::kIsSuffixByLetterFixLength:
+      automaton.ToMCDFA();
+      break;
+  }
+  return automaton;
+}
+
+void RunStage(benchmark::State& state, const Generator& generator,
+              Stage stage) {
+  const std::string regex = generator.regex(state.range(0));
+  const Automaton input = Prepare(regex, stage);
+  size_t vertexes_count = 0;
+  size_t edges_count = 0;
+  size_t stage_peak_bytes = 0;
+
+  // The result of an iteration is destroyed at the start of the next one,
+  // while the timing is paused.
+  std::optional<Automaton> automaton;
+  for (auto _ : state) {
+    state.PauseTiming();
+    automaton.reset();
+    if (stage != Stage::kConstruct) {
+      automaton.emplace(input);
+    }
+    const size_t bytes_before = ResetPeakBytes();
+    state.ResumeTiming();
+
+    switch (stage) {
+      case Stage::kConstruct:
+        automaton.emplace(regex);
+        break;
+      case Stage::kRemoveEpsEdges:
+        automaton->RemoveEpsEdges();
+        break;
+      case Stage::kToDFA:
+        automaton->ToDFA();
+        break;
+      case Stage::kToCDFA:
+        automaton->ToCDFA();
+        break;
+      case Stage::kToMCDFA:
+        automaton->ToMCDFA();
+        break;
+      case Stage::kAdditionToMCDFA:
+        automaton->AdditionToMCDFA();
+        break;
+      case Stage::kIsSuffixByLetterFixLength:
+        benchmark::DoNotOptimize(SuffixQuery(DenseDFA(*automaton))
+                                     .IsSuffixByLetterFixLength('a', 1000));
+        break;
+    }
+
+    state.PauseTiming();
+    stage_peak_bytes = std::max(
+        stage_peak_bytes,
+        peak_live_bytes.load(std::memory_order_relaxed) - bytes_before);
+    vertexes_count = automaton->GetVertexCount();
+    edges_count = automaton->GetEdgeCount();
+    state.ResumeTiming();
+  }
+
+  state.counters["states"] = vertexes_count;
+  state.counters["edges"] = edges_count;
+  state.counters["states_per_second"] = benchmark::Counter(
+      vertexes_count, benchmark::Counter::kIsIterationInvariantRate);
+  state.counters["edges_per_second"] = benchmark::Counter(
+      edges_count, benchmark::Counter::kIsIterationInvariantRate);
+  // Peak of the heap on top of the input of the stage.
+  state.counters["stage_peak_heap_kb"] = stage_peak_bytes / 1024;
+}
+
+// Many words of about the given length, accepted one by one or in lanes.
+void RunAccepts(benchmark::State& state, bool in_lanes) {
+  Automaton automaton(ExponentialBlowUp(10));
+  automaton.ToMCDFA();
+  const DenseDFA dfa(automaton);
+  const BatchRunner runner(dfa);
+
+  std::mt19937 gen(1);
+  const size_t length = state.range(0);
+  std::vector<std::string> strings((1 << 22) / length);
+  size_t bytes = 0;
+  for (std::string& word : strings) {
+    word.resize(length / 2 + gen() % length);
+    for (char& symbol : word) {
+      symbol = "ab"[gen() % 2];
+    }
+    bytes += word.size();
+  }
+  const std::vector<std::string_view> words(strings.begin(), strings.end());
+
+  for (auto _ : state) {
+    if (in_lanes) {
+      benchmark::DoNotOptimize(runner.Accepts(words));
+    } else {
+      size_t accepted_count = 0;
+      for (std::string_view word : words) {
+        accepted_count += dfa.Accepts(word);
+      }
+      benchmark::DoNotOptimize(accepted_count);
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+// One 64 MiB input on the given number of threads. With merging walks the
+// chunks run in parallel; on (abcabc...)* of length 3000 a third of the
+// walks never merge and every chunk but the first is given up and run again
+// serially.
+void RunScan(benchmark::State& state, bool is_merging) {
+  Automaton automaton(is_merging ? ExponentialBlowUp(10)
+                                 : LongConcatenation(3000) + "*");
+  automaton.ToMCDFA();
+  auto dfa = std::make_shared<const DenseDFA>(automaton);
+  const ParallelScanner scanner(dfa, state.range(0));
+
+  std::mt19937 gen(1);
+  std::string input(size_t{1} << 26, 'a');
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = is_merging ? "ab"[gen() % 2] : "abc"[i % 3];
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(scanner.Run(input));
+  }
+  state.SetBytesProcessed(state.iterations() * input.size());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  static const std::vector<Generator> kGenerators = {
+      {"NestedStars", NestedStars, {8, 64, 512}},
+      {"LongConcatenation", LongConcatenation, {64, 1024, 8192}},
+      {"UnionOfLetters", UnionOfLetters, {4, 16, 60}},
+      {"ExponentialBlowUp", ExponentialBlowUp, {2, 6, 10}},
+  };
+  static const std::vector<StageInfo> kStages = {
+      {"Construct", Stage::kConstruct},
+      {"RemoveEpsEdges", Stage::kRemoveEpsEdges},
+      {"ToDFA", Stage::kToDFA},
+      {"ToCDFA", Stage::kToCDFA},
+      {"ToMCDFA", Stage::kToMCDFA},
+      {"AdditionToMCDFA", Stage::kAdditionToMCDFA},
+      {"IsSuffixByLetterFixLength", Stage::kIsSuffixByLetterFixLength},
+  };
+
+  for (const StageInfo& stage : kStages) {
+    for (const Generator& generator : kGenerators) {
+      auto* bench = benchmark::RegisterBenchmark(
+          (std::string(stage.name) + "/" + generator.name).c_str(),
+          [&generator, &stage](benchmark::State& state) {
+            RunStage(state, generator, stage.stage);
+          });
+      for (int64_t size : generator.sizes) {
+        bench->Arg(size);
+      }
+      bench->Unit(benchmark::kMicrosecond);
+    }
+  }
+
+  for (bool in_lanes : {false, true}) {
+    benchmark::RegisterBenchmark(
+        in_lanes ? "Accepts/BatchRunner" : "Accepts/OneByOne",
+        [in_lanes](benchmark::State& state) { RunAccepts(state, in_lanes); })
+        ->Arg(16)
+        ->Arg(256)
+        ->Arg(4096)
+        ->Unit(benchmark::kMicrosecond);
+  }
+
+  // Wall time, as the work is spread over threads.
+  for (bool is_merging : {true, false}) {
+    benchmark::RegisterBenchmark(
+        is_merging ? "Scan/Merging" : "Scan/NoMerging",
+        [is_merging](benchmark::State& state) { RunScan(state, is_merging); })
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(4)
+        ->Arg(8)
+        ->UseRealTime()
+        ->Unit(benchmark::kMillisecond);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,43 @@
+#include "adaptive_matcher.hpp"
+
+AdaptiveMatcher::AdaptiveMatcher(const Automaton& automaton,
+                                 size_t max_dfa_states) {
+  Automaton eps_free = automaton;
+  eps_free.RemoveEpsEdges();
+  // Nothing is left of an automaton without words or with only the empty
+  // one, its DFA is the sink alone.
+  if (eps_free.GetVertexCount() == 0) {
+    engine_ = Engine::kDenseDFA;
+    dense_dfa_.emplace(eps_free);
+    return;
+  }
+  if (eps_free.GetVertexCount() > BitParallelNFA::kMaxVertexCount) {
+    engine_ = Engine::kLazyDFA;
+    lazy_dfa_.emplace(eps_free, max_dfa_states);
+    return;
+  }
+
+  bit_parallel_nfa_.emplace(CsrNFA(eps_free));
+  if (bit_parallel_nfa_->CountReachableSets(max_dfa_states) >
+      max_dfa_states) {
+    engine_ = Engine::kBitParallelNFA;
+    return;
+  }
+
+  engine_ = Engine::kDenseDFA;
+  eps_free.ToMCDFA();
+  dense_dfa_.emplace(eps_free);
+  bit_parallel_nfa_.reset();
+}
+
+bool AdaptiveMatcher::Accepts(std::string_view word) {
+  switch (engine_) {
+    case Engine::kDenseDFA:
+      return dense_dfa_->Accepts(word);
+    case Engine::kBitParallelNFA:
+      return bit_parallel_nfa_->Accepts(word);
+    case Engine::kLazyDFA:
+      return lazy_dfa_->Accepts(word);
+  }
+  return false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include "automaton.hpp"
+#include "bit_parallel_nfa.hpp"
+#include "dense_dfa.hpp"
+#include "lazy_dfa.hpp"
+
+// Picks how to match the words of one automaton, so that the determinization
+// is not paid for when it would blow up. If the eps-free automaton fits into
+// BitParallelNFA, the subsets are counted as bitmasks: the minimal DFA is
+// built only if there are at most max_dfa_states of them, otherwise the sets
+// are simulated. Larger automata are determinized lazily by LazyDFA.
+class AdaptiveMatcher {
+ public:
+  enum class Engine { kDenseDFA, kBitParallelNFA, kLazyDFA };
+
+  static constexpr size_t kDefaultMaxDFAStates = 4096;
+
+ private:
+  Engine engine_;
+  std::optional<DenseDFA> dense_dfa_;
+  std::optional<BitParallelNFA> bit_parallel_nfa_;
+  std::optional<LazyDFA> lazy_dfa_;
+
+ public:
+  explicit AdaptiveMatcher(const Automaton& automaton,
+                           size_t max_dfa_states = kDefaultMaxDFAStates);
+
+  Engine GetEngine() const { return engine_; }
+
+  // Not thread-safe, LazyDFA fills its cache while matching.
+  bool Accepts(std::string_view word);
+};
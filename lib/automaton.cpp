@@ -1,15 +1,66 @@
 #include "automaton.hpp"
+#include "concurrent_subset_table.hpp"
+#include "csr_nfa.hpp"
+#include "dense_dfa.hpp"
+#include "pipeline_stats.hpp"
+#include "regex_cache.hpp"
+#include "suffix_query.hpp"
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Appends the statistics of a stage to the sink when the stage finishes.
+// Does nothing if there is no sink or the stage is left by an exception.
+class StageTimer {
+ private:
+  PipelineStats* stats_;
+  const char* name_;
+  const Automaton& automaton_;
+  int exceptions_count_ = 0;
+  std::chrono::steady_clock::time_point start_;
+
+ public:
+  StageTimer(PipelineStats* stats, const char* name, const Automaton& automaton)
+      : stats_(stats), name_(name), automaton_(automaton) {
+    if (stats_ != nullptr) {
+      exceptions_count_ = std::uncaught_exceptions();
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  StageTimer(const StageTimer&) = delete;
+
+  StageTimer& operator=(const StageTimer&) = delete;
+
+  ~StageTimer() {
+    if (stats_ == nullptr || std::uncaught_exceptions() > exceptions_count_) {
+      return;
+    }
+    std::chrono::duration<double> duration =
+        std::chrono::steady_clock::now() - start_;
+    stats_->stages.push_back({name_, automaton_.GetVertexCount(),
+                              automaton_.GetEdgeCount(),
+                              automaton_.GetMemoryUsage(), duration.count()});
+  }
+};
+
+}  // namespace
 
 bool Automaton::IsEps(const char symbol) {
   return symbol == kEps;
 }
 
-char Automaton::GetSymbolOfEdge(Edge edge) {
+char Automaton::GetSymbolOfEdge(const Edge& edge) {
   return edge.first;
 }
 
-const std::vector<size_t> Automaton::GetNeighborsOfEdge(Edge edge) {
+const std::vector<size_t>& Automaton::GetNeighborsOfEdge(const Edge& edge) {
   return edge.second;
 }
 
@@ -17,11 +68,47 @@ size_t Automaton::GetVertexCount() const {
   return vertexes_count_;
 }
 
+size_t Automaton::GetEdgeCount() const {
+  size_t edges_count = 0;
+  for (size_t v = 0; v < vertexes_count_; ++v) {
+    for (const auto& edge : edges_[v]) {
+      edges_count += GetNeighborsOfEdge(edge).size();
+    }
+  }
+  return edges_count;
+}
+
 std::string Automaton::GetAlphabet() const {
   return alphabet_;
 }
 
+size_t Automaton::GetMemoryUsage() const {
+  // Nodes of the hash tables and of the set hold two pointers of overhead.
+  constexpr size_t kNodeOverhead = 2 * sizeof(void*);
+  size_t bytes = alphabet_.capacity() + edges_.capacity() * sizeof(edges_[0]) +
+                 terminal_vertexes_.size() * (sizeof(size_t) + kNodeOverhead);
+  for (const auto& vertex_edges : edges_) {
+    bytes += vertex_edges.bucket_count() * sizeof(void*);
+    for (const auto& edge : vertex_edges) {
+      bytes += sizeof(edge) + kNodeOverhead +
+               GetNeighborsOfEdge(edge).capacity() * sizeof(size_t);
+    }
+  }
+  return bytes;
+}
+
+void Automaton::SetStats(PipelineStats* stats) {
+  stats_ = stats;
+}
+
 void Automaton::AddEdge(size_t from, size_t to, char symbol) {
+  // The determinization has a column for every letter of the alphabet only.
+  if (!IsEps(symbol)) {
+    auto it = std::lower_bound(alphabet_.begin(), alphabet_.end(), symbol);
+    if (it == alphabet_.end() || *it != symbol) {
+      alphabet_.insert(it, symbol);
+    }
+  }
   edges_[from][symbol].push_back(to);
 }
 
@@ -42,61 +129,240 @@ Automaton::Automaton(const char symbol) {
   }
 }
 
-Automaton::Automaton(const std::string& regex) {
-  std::stack<Automaton> st;
-  for (char current_symbol : regex) {
-    if (current_symbol == '+') {
-      if (st.empty()) {
+Automaton::Automaton(const std::string& regex, PipelineStats* stats)
+    : Automaton(regex, RegexConstruction::kThompson, stats) {}
+
+Automaton::Automaton(const std::string& regex, RegexConstruction construction,
+                     PipelineStats* stats)
+    : stats_(stats) {
+  StageTimer timer(stats_, "Construct", *this);
+  if (construction == RegexConstruction::kGlushkov) {
+    BuildGlushkov(regex);
+  } else {
+    BuildThompson(regex);
+  }
+}
+
+void Automaton::BuildThompson(const std::string& regex) {
+  // Thompson construction in two passes over the reverse Polish notation.
+  // The first pass checks the regex and finds the size of every fragment and
+  // the positions of its start and terminal inside it. The second pass goes
+  // from the whole automaton down to the letters, places every fragment at
+  // its offset and writes its edges into one preallocated list, so the edges
+  // of every vertex keep the order operator+, operator- and operator* give.
+  const size_t tokens_count = regex.size();
+  std::vector<size_t> left(tokens_count);
+  std::vector<size_t> right(tokens_count);
+  std::vector<size_t> size(tokens_count);
+  std::vector<size_t> start(tokens_count);
+  std::vector<size_t> term(tokens_count);
+  std::vector<size_t> st;
+  size_t edges_count = 0;
+
+  for (size_t i = 0; i < tokens_count; ++i) {
+    char current_symbol = regex[i];
+    if (current_symbol == '+' || current_symbol == '.') {
+      if (st.size() < 2) {
         throw std::runtime_error("Incorrect regex");
       }
+      right[i] = st.back();
+      st.pop_back();
+      left[i] = st.back();
+      st.pop_back();
+
+      if (current_symbol == '+') {
+        size[i] = 2 + size[left[i]] + size[right[i]];
+        start[i] = 0;
+        term[i] = size[i] - 1;
+        edges_count += 4;
+      } else {
+        size[i] = size[left[i]] + size[right[i]];
+        start[i] = start[left[i]];
+        term[i] = size[left[i]] + term[right[i]];
+        edges_count += 1;
+      }
 
-      Automaton second = st.top();
-      st.pop();
-
+    } else if (current_symbol == '*') {
       if (st.empty()) {
         throw std::runtime_error("Incorrect regex");
       }
+      left[i] = st.back();
+      st.pop_back();
 
-      Automaton first = st.top();
-      st.pop();
+      size[i] = 1 + size[left[i]];
+      start[i] = 0;
+      term[i] = 0;
+      edges_count += 2;
 
-      st.push(first + second);
+    } else if (IsEps(current_symbol)) {
+      size[i] = 1;
+      start[i] = 0;
+      term[i] = 0;
+
+    } else {
+      size[i] = 2;
+      start[i] = 0;
+      term[i] = 1;
+      edges_count += 1;
+    }
+    st.push_back(i);
+  }
+  if (st.size() != 1) {
+    throw std::runtime_error("Incorrect regex");
+  }
+
+  const size_t root = st.back();
+  std::vector<size_t> offset(tokens_count);
+  std::vector<EdgeHelper> list;
+  list.reserve(edges_count);
+  offset[root] = 0;
+
+  // Operands always precede their operator, so walking backwards visits
+  // every fragment before the fragments inside it.
+  for (size_t i = root + 1; i-- > 0;) {
+    char current_symbol = regex[i];
+    size_t first = left[i];
+    size_t second = right[i];
+    if (current_symbol == '+') {
+      offset[first] = offset[i] + 1;
+      offset[second] = offset[first] + size[first];
+      size_t res_term = offset[i] + term[i];
+      list.emplace_back(offset[i], offset[first] + start[first], kEps);
+      list.emplace_back(offset[i], offset[second] + start[second], kEps);
+      list.emplace_back(offset[first] + term[first], res_term, kEps);
+      list.emplace_back(offset[second] + term[second], res_term, kEps);
 
     } else if (current_symbol == '.') {
-      if (st.empty()) {
-        throw std::runtime_error("Incorrect regex");
-      }
+      offset[first] = offset[i];
+      offset[second] = offset[first] + size[first];
+      list.emplace_back(offset[first] + term[first],
+                        offset[second] + start[second], kEps);
 
-      Automaton second = st.top();
-      st.pop();
+    } else if (current_symbol == '*') {
+      offset[first] = offset[i] + 1;
+      list.emplace_back(offset[i], offset[first] + start[first], kEps);
+      list.emplace_back(offset[first] + term[first], offset[i], kEps);
 
-      if (st.empty()) {
-        throw std::runtime_error("Incorrect regex");
+    } else if (!IsEps(current_symbol)) {
+      list.emplace_back(offset[i], offset[i] + 1, current_symbol);
+    }
+  }
+
+  start_ = start[root];
+  terminal_vertexes_ = {term[root]};
+  vertexes_count_ = size[root];
+  edges_.resize(vertexes_count_);
+  for (const EdgeHelper& edge : list) {
+    AddEdge(edge.from, edge.to, edge.symbol);
+  }
+}
+
+void Automaton::AppendEdges(const Automaton& other, size_t shift) {
+  for (size_t v = 0; v < other.vertexes_count_; ++v) {
+    auto& vertex_edges = edges_[v + shift];
+    vertex_edges.reserve(vertex_edges.size() + other.edges_[v].size());
+    for (const auto& [symbol, neighbors] : other.edges_[v]) {
+      std::vector<size_t>& targets = vertex_edges[symbol];
+      targets.reserve(targets.size() + neighbors.size());
+      for (size_t to : neighbors) {
+        targets.push_back(to + shift);
       }
+    }
+  }
+}
+
+void Automaton::BuildGlushkov(const std::string& regex) {
+  // Every fragment is described by whether it accepts the empty word and by
+  // the positions (occurrences of letters) its words can start and end with.
+  // The sets of different operands never intersect, so they are joined by
+  // appending the smaller one to the larger one.
+  struct Fragment {
+    bool nullable;
+    std::vector<size_t> first;
+    std::vector<size_t> last;
+  };
+  auto join = [](std::vector<size_t>& to, std::vector<size_t>& from) {
+    if (to.size() < from.size()) {
+      to.swap(from);
+    }
+    to.insert(to.end(), from.begin(), from.end());
+  };
 
-      Automaton first = st.top();
-      st.pop();
+  std::vector<Fragment> st;
+  std::vector<char> letters(1, kEps);  // position 0 is the start
+  std::vector<std::vector<size_t>> follow(1);
 
-      st.push(first - second);
+  for (char current_symbol : regex) {
+    if (current_symbol == '+' || current_symbol == '.') {
+      if (st.size() < 2) {
+        throw std::runtime_error("Incorrect regex");
+      }
+      Fragment second = std::move(st.back());
+      st.pop_back();
+      Fragment& first = st.back();
+
+      if (current_symbol == '+') {
+        first.nullable = first.nullable || second.nullable;
+        join(first.first, second.first);
+        join(first.last, second.last);
+      } else {
+        for (size_t p : first.last) {
+          follow[p].insert(follow[p].end(), second.first.begin(),
+                           second.first.end());
+        }
+        if (first.nullable) {
+          join(first.first, second.first);
+        }
+        if (second.nullable) {
+          join(second.last, first.last);
+        }
+        first.last = std::move(second.last);
+        first.nullable = first.nullable && second.nullable;
+      }
 
     } else if (current_symbol == '*') {
       if (st.empty()) {
         throw std::runtime_error("Incorrect regex");
       }
+      Fragment& fragment = st.back();
+      for (size_t p : fragment.last) {
+        follow[p].insert(follow[p].end(), fragment.first.begin(),
+                         fragment.first.end());
+      }
+      fragment.nullable = true;
 
-      Automaton first = st.top();
-      st.pop();
-
-      st.push(*first);
+    } else if (IsEps(current_symbol)) {
+      st.push_back({true, {}, {}});
 
     } else {
-      st.push(Automaton(current_symbol));
+      size_t position = letters.size();
+      letters.push_back(current_symbol);
+      follow.emplace_back();
+      st.push_back({false, {position}, {position}});
     }
   }
-  if (st.empty() || st.size() > 1) {
+  if (st.size() != 1) {
     throw std::runtime_error("Incorrect regex");
   }
-  *this = st.top();
+
+  Fragment& root = st.back();
+  follow[0] = std::move(root.first);
+  start_ = 0;
+  terminal_vertexes_ = std::set<size_t>(root.last.begin(), root.last.end());
+  if (root.nullable) {
+    terminal_vertexes_.insert(0);
+  }
+
+  vertexes_count_ = letters.size();
+  edges_.resize(vertexes_count_);
+  for (size_t p = 0; p < vertexes_count_; ++p) {
+    std::sort(follow[p].begin(), follow[p].end());
+    follow[p].erase(std::unique(follow[p].begin(), follow[p].end()),
+                    follow[p].end());
+    for (size_t q : follow[p]) {
+      AddEdge(p, q, letters[q]);
+    }
+  }
 }
 
 std::string UnionStrings(std::string first, std::string second) {
@@ -137,25 +403,8 @@ Automaton operator+(const Automaton& first, const Automaton& second) {
 
   result.alphabet_ = UnionStrings(first.GetAlphabet(), second.GetAlphabet());
 
-  for (size_t first_vertex = 0; first_vertex < first.GetVertexCount();
-       ++first_vertex) {
-    for (auto edge : first.edges_[first_vertex]) {
-      char symbol = Automaton::GetSymbolOfEdge(edge);
-      for (size_t to : Automaton::GetNeighborsOfEdge(edge)) {
-        result.AddEdge(first_vertex + first_shift, to + first_shift, symbol);
-      }
-    }
-  }
-
-  for (size_t second_vertex = 0; second_vertex < second.GetVertexCount();
-       ++second_vertex) {
-    for (auto edge : second.edges_[second_vertex]) {
-      char symbol = Automaton::GetSymbolOfEdge(edge);
-      for (size_t to : Automaton::GetNeighborsOfEdge(edge)) {
-        result.AddEdge(second_vertex + second_shift, to + second_shift, symbol);
-      }
-    }
-  }
+  result.AppendEdges(first, first_shift);
+  result.AppendEdges(second, second_shift);
 
   return result;
 }
@@ -176,25 +425,8 @@ Automaton operator-(const Automaton& first, const Automaton& second) {
 
   result.alphabet_ = UnionStrings(first.GetAlphabet(), second.GetAlphabet());
 
-  for (size_t first_vertex = 0; first_vertex < first.GetVertexCount();
-       ++first_vertex) {
-    for (auto edge : first.edges_[first_vertex]) {
-      char symbol = Automaton::GetSymbolOfEdge(edge);
-      for (size_t to : Automaton::GetNeighborsOfEdge(edge)) {
-        result.AddEdge(first_vertex + first_shift, to + first_shift, symbol);
-      }
-    }
-  }
-
-  for (size_t second_vertex = 0; second_vertex < second.GetVertexCount();
-       ++second_vertex) {
-    for (auto edge : second.edges_[second_vertex]) {
-      char symbol = Automaton::GetSymbolOfEdge(edge);
-      for (size_t to : Automaton::GetNeighborsOfEdge(edge)) {
-        result.AddEdge(second_vertex + second_shift, to + second_shift, symbol);
-      }
-    }
-  }
+  result.AppendEdges(first, first_shift);
+  result.AppendEdges(second, second_shift);
 
   return result;
 }
@@ -213,15 +445,7 @@ Automaton operator*(const Automaton& first) {
 
   result.alphabet_ = first.GetAlphabet();
 
-  for (size_t first_vertex = 0; first_vertex < first.GetVertexCount();
-       ++first_vertex) {
-    for (auto edge : first.edges_[first_vertex]) {
-      char symbol = Automaton::GetSymbolOfEdge(edge);
-      for (size_t to : Automaton::GetNeighborsOfEdge(edge)) {
-        result.AddEdge(first_vertex + first_shift, to + first_shift, symbol);
-      }
-    }
-  }
+  result.AppendEdges(first, first_shift);
 
   return result;
 }
@@ -278,12 +502,11 @@ std::ostream& operator<<(std::ostream& out, const Automaton& automaton) {
   }
   out << "\n";
 
-  for (size_t from = 0; from < automaton.vertexes_count_; ++from) {
-    for (auto edge : automaton.edges_[from]) {
-      char symbol = Automaton::GetSymbolOfEdge(edge);
-      for (size_t to : Automaton::GetNeighborsOfEdge(edge)) {
-        out << from << ' ' << to << ' ' << symbol << '\n';
-      }
+  CsrNFA nfa(automaton);
+  for (size_t from = 0; from < nfa.GetVertexCount(); ++from) {
+    for (size_t e = nfa.EdgesBegin(from); e < nfa.EdgesEnd(from); ++e) {
+      out << from << ' ' << nfa.GetTarget(e) << ' ' << nfa.GetSymbol(e)
+          << '\n';
     }
   }
   return out;
@@ -300,12 +523,15 @@ bool operator==(const Automaton& first, const Automaton& second) {
 }
 
 std::vector<Automaton::EdgeHelper> Automaton::GetEdgesList(
-    std::set<size_t> edges_to_remove) {
+    const std::vector<bool>& is_removed) {
   std::vector<EdgeHelper> res;
   for (size_t from = 0; from < vertexes_count_; ++from) {
-    for (auto edge : edges_[from]) {
+    if (!is_removed.empty() && is_removed[from]) {
+      continue;
+    }
+    for (const auto& edge : edges_[from]) {
       for (auto to : Automaton::GetNeighborsOfEdge(edge)) {
-        if (edges_to_remove.count(from) || edges_to_remove.count(to)) {
+        if (!is_removed.empty() && is_removed[to]) {
           continue;
         }
         auto tmp = EdgeHelper(from, to, GetSymbolOfEdge(edge));
@@ -381,145 +607,384 @@ void Automaton::CompressAndAssignEdges(
   start_ = GetNewVertexNumber(compressed_list, start_);
 }
 
+std::vector<bool> Automaton::GetReachableVertexes(
+    const std::vector<std::vector<size_t>>& adjacency,
+    const std::vector<size_t>& sources) {
+  std::vector<bool> is_reach(adjacency.size(), false);
+  std::queue<size_t> q;
+  for (size_t v : sources) {
+    if (!is_reach[v]) {
+      is_reach[v] = true;
+      q.push(v);
+    }
+  }
+
+  while (!q.empty()) {
+    size_t v = q.front();
+    q.pop();
+    for (size_t to : adjacency[v]) {
+      if (!is_reach[to]) {
+        is_reach[to] = true;
+        q.push(to);
+      }
+    }
+  }
+  return is_reach;
+}
+
 void Automaton::RemoveReachLessVertex() {
-  std::set<size_t> edges_to_remove;
+  StageTimer timer(stats_, "RemoveReachLessVertex", *this);
+  // An empty automaton has no start vertex to search from.
+  if (vertexes_count_ == 0) {
+    return;
+  }
+  std::vector<std::vector<size_t>> forward(vertexes_count_);
+  std::vector<std::vector<size_t>> backward(vertexes_count_);
+  for (size_t v = 0; v < vertexes_count_; ++v) {
+    for (const auto& edge : edges_[v]) {
+      for (size_t to : GetNeighborsOfEdge(edge)) {
+        forward[v].push_back(to);
+        backward[to].push_back(v);
+      }
+    }
+  }
 
-  std::vector<std::bitset<kMaxVertex>> is_reach(vertexes_count_, 0);
+  std::vector<bool> is_reach = GetReachableVertexes(forward, {start_});
+  std::vector<bool> is_coreach = GetReachableVertexes(
+      backward, std::vector<size_t>(terminal_vertexes_.begin(),
+                                    terminal_vertexes_.end()));
+
+  std::vector<bool> is_removed(vertexes_count_);
   for (size_t v = 0; v < vertexes_count_; ++v) {
-    is_reach[v][v] = true;
+    is_removed[v] = !is_reach[v] || !is_coreach[v];
   }
 
-  for (size_t i = 0; i < vertexes_count_; ++i) {
-    for (size_t v = 0; v < vertexes_count_; ++v) {
-      for (auto edge : edges_[v]) {
-        for (size_t to : Automaton::GetNeighborsOfEdge(edge)) {
-          is_reach[v] |= is_reach[to];
-        }
+  auto list = GetEdgesList(is_removed);
+  CompressAndAssignEdges(list);
+}
+
+std::vector<std::vector<size_t>> Automaton::GetEpsClosures(
+    const CsrNFA& nfa, std::vector<size_t>& component) {
+  const size_t vertexes_count = nfa.GetVertexCount();
+  std::vector<size_t> eps_begin(vertexes_count + 1, 0);
+  std::vector<size_t> eps_edges;
+  for (size_t from = 0; from < vertexes_count; ++from) {
+    for (size_t e = nfa.EdgesBegin(from); e < nfa.EdgesEnd(from); ++e) {
+      if (IsEps(nfa.GetSymbol(e))) {
+        eps_edges.push_back(nfa.GetTarget(e));
       }
     }
+    eps_begin[from + 1] = eps_edges.size();
   }
 
-  for (size_t v = 0; v < vertexes_count_; ++v) {
-    if (!is_reach[start_][v]) {
-      edges_to_remove.insert(v);
+  // Tarjan's algorithm finds the strongly connected components of the eps
+  // subgraph in reverse topological order, so the closure of a component is
+  // its vertexes plus the closures of the components it has eps edges to.
+  const size_t kUnvisited = vertexes_count;
+  std::vector<size_t> index(vertexes_count, kUnvisited);
+  std::vector<size_t> low(vertexes_count);
+  std::vector<bool> on_stack(vertexes_count, false);
+  std::vector<size_t> st;
+  std::vector<std::pair<size_t, size_t>> dfs;
+  std::vector<std::vector<size_t>> component_closures;
+  size_t counter = 0;
+  component.assign(vertexes_count, kUnvisited);
+
+  for (size_t root = 0; root < vertexes_count; ++root) {
+    if (index[root] != kUnvisited) {
+      continue;
     }
+    dfs.emplace_back(root, eps_begin[root]);
+    while (!dfs.empty()) {
+      auto& [v, next] = dfs.back();
+      if (index[v] == kUnvisited) {
+        index[v] = low[v] = counter++;
+        st.push_back(v);
+        on_stack[v] = true;
+      }
 
-    bool ok = true;
-    for (size_t u = 0; u < vertexes_count_; ++u) {
-      if (terminal_vertexes_.count(u) && is_reach[v][u]) {
-        ok = true;
+      if (next < eps_begin[v + 1]) {
+        size_t to = eps_edges[next++];
+        if (index[to] == kUnvisited) {
+          dfs.emplace_back(to, eps_begin[to]);
+        } else if (on_stack[to]) {
+          low[v] = std::min(low[v], index[to]);
+        }
+        continue;
       }
-    }
 
-    if (!ok) {
-      edges_to_remove.insert(v);
+      size_t u = v;
+      dfs.pop_back();
+      if (!dfs.empty()) {
+        low[dfs.back().first] = std::min(low[dfs.back().first], low[u]);
+      }
+      if (low[u] != index[u]) {
+        continue;
+      }
+
+      std::vector<size_t> closure;
+      size_t w = 0;
+      do {
+        w = st.back();
+        st.pop_back();
+        on_stack[w] = false;
+        component[w] = component_closures.size();
+        closure.push_back(w);
+      } while (w != u);
+
+      const size_t members_count = closure.size();
+      for (size_t i = 0; i < members_count; ++i) {
+        for (size_t e = eps_begin[closure[i]]; e < eps_begin[closure[i] + 1];
+             ++e) {
+          size_t to = eps_edges[e];
+          if (component[to] != component_closures.size()) {
+            const std::vector<size_t>& other = component_closures[component[to]];
+            closure.insert(closure.end(), other.begin(), other.end());
+          }
+        }
+      }
+      std::sort(closure.begin(), closure.end());
+      closure.erase(std::unique(closure.begin(), closure.end()), closure.end());
+      component_closures.push_back(std::move(closure));
     }
   }
-
-  auto list = GetEdgesList(edges_to_remove);
-  CompressAndAssignEdges(list);
+  return component_closures;
 }
 
 void Automaton::RemoveEpsEdges() {
-  std::vector<std::bitset<kMaxVertex>> is_reach(vertexes_count_, 0);
-  std::vector<std::vector<EdgeHelper>> eps_edges(vertexes_count_);
+  StageTimer timer(stats_, "RemoveEpsEdges", *this);
+  // Nothing to close over, e.g. when the automaton is already eps-free.
+  bool has_eps = false;
+  for (const auto& vertex_edges : edges_) {
+    has_eps = has_eps || vertex_edges.count(kEps) != 0;
+  }
+  if (!has_eps) {
+    RemoveReachLessVertex();
+    return;
+  }
 
-  for (size_t from = 0; from < vertexes_count_; ++from) {
-    for (auto edge : edges_[from]) {
-      char symbol = GetSymbolOfEdge(edge);
-      for (size_t to : GetNeighborsOfEdge(edge)) {
-        if (IsEps(symbol)) {
-          eps_edges[from].push_back(EdgeHelper(from, to, symbol));
+  CsrNFA nfa(*this);
+  Edges().swap(edges_);
+
+  std::vector<size_t> component;
+  std::vector<std::vector<size_t>> closures = GetEpsClosures(nfa, component);
+
+  edges_.resize(vertexes_count_);
+  std::set<size_t> new_terms;
+  for (size_t v = 0; v < vertexes_count_; ++v) {
+    for (size_t u : closures[component[v]]) {
+      for (size_t e = nfa.EdgesBegin(u); e < nfa.EdgesEnd(u); ++e) {
+        char symbol = nfa.GetSymbol(e);
+        if (!IsEps(symbol)) {
+          edges_[v][symbol].push_back(nfa.GetTarget(e));
         }
       }
+      if (nfa.IsTerminal(u)) {
+        new_terms.insert(v);
+      }
     }
-    is_reach[from][from] = true;
   }
+  terminal_vertexes_ = std::move(new_terms);
+  RemoveReachLessVertex();
+}
 
-  for (size_t i = 0; i < vertexes_count_; ++i) {
-    for (size_t v = 0; v < vertexes_count_; ++v) {
-      for (const EdgeHelper& edge : eps_edges[v]) {
-        size_t to = edge.to;
-        is_reach[v] |= is_reach[to];
-      }
+bool Automaton::GetSubsetTargets(const CsrNFA& nfa,
+                                 const std::vector<int>& symbol_index,
+                                 const SubsetTable::Subset& subset,
+                                 std::vector<SubsetTable::Subset>& delta) {
+  bool is_terminal = false;
+  for (size_t v : subset) {
+    is_terminal = is_terminal || nfa.IsTerminal(v);
+    for (size_t e = nfa.EdgesBegin(v); e < nfa.EdgesEnd(v); ++e) {
+      int index = symbol_index[static_cast<unsigned char>(nfa.GetSymbol(e))];
+      delta[index].push_back(nfa.GetTarget(e));
     }
   }
 
-  std::vector<std::unordered_map<char, std::vector<size_t>>> new_edges(
-      vertexes_count_);
-  for (size_t v = 0; v < vertexes_count_; ++v) {
-    for (size_t u = 0; u < vertexes_count_; ++u) {
-      if (is_reach[v][u]) {
-        for (auto edge : edges_[u]) {
-          char symbol = GetSymbolOfEdge(edge);
-          for (size_t to : GetNeighborsOfEdge(edge)) {
-            if (!IsEps(symbol)) {
-              new_edges[v][symbol].push_back(to);
-            }
-          }
+  for (SubsetTable::Subset& targets : delta) {
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+  }
+  return is_terminal;
+}
+
+void Automaton::ExploreSubsetsParallel(const CsrNFA& nfa,
+                                       const std::vector<int>& symbol_index,
+                                       size_t threads_count,
+                                       ConcurrentSubsetTable& subsets,
+                                       std::vector<EdgeHelper>& list,
+                                       std::vector<size_t>& terms) {
+  using Item = std::pair<size_t, const SubsetTable::Subset*>;
+
+  // Every thread takes the newest subsets from the back of its own deque and
+  // steals the oldest ones from the front of the others.
+  struct WorkDeque {
+    std::mutex mutex;
+    std::deque<Item> items;
+  };
+  std::vector<WorkDeque> deques(threads_count);
+  std::vector<std::vector<EdgeHelper>> thread_lists(threads_count);
+  std::vector<std::vector<size_t>> thread_terms(threads_count);
+  // Subsets that were found but are not expanded yet.
+  std::atomic<size_t> pending_count = 1;
+
+  auto start = subsets.Insert({start_});
+  deques[0].items.emplace_back(start.id, start.subset);
+
+  auto take = [&deques, threads_count](size_t thread, Item& item) {
+    for (size_t i = 0; i < threads_count; ++i) {
+      WorkDeque& deque = deques[(thread + i) % threads_count];
+      std::lock_guard lock(deque.mutex);
+      if (deque.items.empty()) {
+        continue;
+      }
+      if (i == 0) {
+        item = deque.items.back();
+        deque.items.pop_back();
+      } else {
+        item = deque.items.front();
+        deque.items.pop_front();
+      }
+      return true;
+    }
+    return false;
+  };
+
+  auto work = [&](size_t thread) {
+    std::vector<SubsetTable::Subset> delta(alphabet_.size());
+    Item item;
+    while (pending_count != 0) {
+      if (!take(thread, item)) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      auto [id, subset] = item;
+      if (GetSubsetTargets(nfa, symbol_index, *subset, delta)) {
+        thread_terms[thread].push_back(id);
+      }
+      for (size_t index = 0; index < delta.size(); ++index) {
+        if (delta[index].empty()) {
+          continue;
         }
-        if (terminal_vertexes_.count(u)) {
-          terminal_vertexes_.insert(v);
+        auto [to, inserted, target] = subsets.Insert(delta[index]);
+        thread_lists[thread].emplace_back(id, to, alphabet_[index]);
+        if (inserted) {
+          ++pending_count;
+          std::lock_guard lock(deques[thread].mutex);
+          deques[thread].items.emplace_back(to, target);
         }
+        delta[index].clear();
       }
+      --pending_count;
     }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t thread = 1; thread < threads_count; ++thread) {
+    threads.emplace_back(work, thread);
+  }
+  work(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (size_t thread = 0; thread < threads_count; ++thread) {
+    list.insert(list.end(), thread_lists[thread].begin(),
+                thread_lists[thread].end());
+    terms.insert(terms.end(), thread_terms[thread].begin(),
+                 thread_terms[thread].end());
   }
-  edges_ = new_edges;
-  RemoveReachLessVertex();
 }
 
-bool Automaton::GetBit(size_t mask, size_t pos) {
-  return mask & (1 << pos);
+void Automaton::AssignSubsetAutomaton(
+    const std::vector<const SubsetTable::Subset*>& subsets,
+    std::vector<EdgeHelper>& list, const std::vector<size_t>& terms) {
+  if (stats_ != nullptr) {
+    stats_->subsets_count += subsets.size();
+    for (const SubsetTable::Subset* subset : subsets) {
+      stats_->subsets_bytes +=
+          sizeof(SubsetTable::Subset) + subset->size() * sizeof(size_t);
+    }
+  }
+
+  // Subsets are numbered in the order of their bitmasks, so the result does
+  // not depend on the order in which they were discovered.
+  std::vector<size_t> ranks = SubsetTable::GetMaskOrderRanks(subsets);
+  for (EdgeHelper& edge : list) {
+    edge.from = ranks[edge.from];
+    edge.to = ranks[edge.to];
+  }
+
+  std::set<size_t> new_terms;
+  for (size_t id : terms) {
+    new_terms.insert(ranks[id]);
+  }
+
+  start_ = ranks[0];
+  terminal_vertexes_ = new_terms;
+  CompressAndAssignEdges(list);
 }
 
-void Automaton::ToDFA() {
+void Automaton::ToDFA(size_t threads_count) {
+  StageTimer timer(stats_, "ToDFA", *this);
   RemoveEpsEdges();
+  if (vertexes_count_ == 0) {
+    return;
+  }
+
+  CsrNFA nfa(*this);
+  Edges().swap(edges_);
+
+  std::vector<int> symbol_index(256, -1);
+  for (size_t i = 0; i < alphabet_.size(); ++i) {
+    symbol_index[static_cast<unsigned char>(alphabet_[i])] = i;
+  }
+
   std::vector<EdgeHelper> list;
+  std::vector<size_t> terms;
+
+  if (threads_count > 1) {
+    ConcurrentSubsetTable subsets;
+    ExploreSubsetsParallel(nfa, symbol_index, threads_count, subsets, list,
+                           terms);
+    AssignSubsetAutomaton(subsets.GetSubsets(), list, terms);
+    return;
+  }
+
   std::queue<size_t> q;
-  q.push((1 << start_));
-  start_ = (1 << start_);
-  std::set<size_t> used;
-  std::set<size_t> new_terms;
+  SubsetTable subsets;
+  std::vector<SubsetTable::Subset> delta(alphabet_.size());
+
+  q.push(subsets.Insert({start_}).first);
 
   while (!q.empty()) {
-    size_t mask = q.front();
+    size_t id = q.front();
     q.pop();
 
-    if (used.count(mask)) {
-      continue;
+    if (GetSubsetTargets(nfa, symbol_index, subsets.Get(id), delta)) {
+      terms.push_back(id);
     }
-
-    for (size_t v = 0; v < vertexes_count_; ++v) {
-      if (terminal_vertexes_.count(v) && GetBit(mask, v)) {
-        new_terms.insert(mask);
-        break;
+    for (size_t index = 0; index < delta.size(); ++index) {
+      SubsetTable::Subset& targets = delta[index];
+      if (targets.empty()) {
+        continue;
       }
-    }
-
-    used.insert(mask);
-    std::unordered_map<char, size_t> delta;
-    for (size_t v = 0; v < vertexes_count_; ++v) {
-      if (GetBit(mask, v)) {
-        for (auto edge : edges_[v]) {
-          char symbol = GetSymbolOfEdge(edge);
-          for (size_t to : GetNeighborsOfEdge(edge)) {
-            delta[symbol] |= (1 << to);
-          }
-        }
+      auto [to, inserted] = subsets.Insert(targets);
+      list.emplace_back(EdgeHelper(id, to, alphabet_[index]));
+      if (inserted) {
+        q.push(to);
       }
-    }
-
-    for (auto el : delta) {
-      list.emplace_back(EdgeHelper(mask, el.second, el.first));
-      q.push(el.second);
+      targets.clear();
     }
   }
-  terminal_vertexes_ = new_terms;
-  CompressAndAssignEdges(list);
+
+  AssignSubsetAutomaton(subsets.GetSubsets(), list, terms);
 }
 
-void Automaton::ToCDFA() {
-  ToDFA();
+void Automaton::ToCDFA(size_t threads_count) {
+  StageTimer timer(stats_, "ToCDFA", *this);
+  ToDFA(threads_count);
 
   auto list = GetEdgesList();
   size_t stok = vertexes_count_;
@@ -527,7 +992,7 @@ void Automaton::ToCDFA() {
 
   for (size_t v = 0; v < vertexes_count_; ++v) {
     std::set<char> used;
-    for (auto edge : edges_[v]) {
+    for (const auto& edge : edges_[v]) {
       used.insert(GetSymbolOfEdge(edge));
     }
 
@@ -551,7 +1016,7 @@ void Automaton::AdditionToMCDFA() {
   ToCDFA();
   std::set<size_t> set;
   for (size_t from = 0; from < vertexes_count_; ++from) {
-    for (auto edge : edges_[from]) {
+    for (const auto& edge : edges_[from]) {
       char symbol = GetSymbolOfEdge(edge);
       for (size_t to : GetNeighborsOfEdge(edge)) {
         set.insert(from);
@@ -567,9 +1032,45 @@ void Automaton::AdditionToMCDFA() {
   terminal_vertexes_ = set;
 }
 
-void Automaton::ToMCDFA() {
-  ToCDFA();
+void Automaton::Reverse() {
+  if (vertexes_count_ == 0) {
+    return;
+  }
+  Edges reversed(vertexes_count_ + 1);
+  for (size_t from = 0; from < vertexes_count_; ++from) {
+    for (const auto& edge : edges_[from]) {
+      char symbol = GetSymbolOfEdge(edge);
+      for (size_t to : GetNeighborsOfEdge(edge)) {
+        reversed[to][symbol].push_back(from);
+      }
+    }
+  }
 
+  const size_t new_start = vertexes_count_;
+  for (size_t term : terminal_vertexes_) {
+    reversed[new_start][kEps].push_back(term);
+  }
+  terminal_vertexes_ = {start_};
+  start_ = new_start;
+  ++vertexes_count_;
+  edges_ = std::move(reversed);
+}
+
+void Automaton::AddAnyPrefix() {
+  if (vertexes_count_ == 0) {
+    return;
+  }
+  const size_t new_start = vertexes_count_;
+  ++vertexes_count_;
+  edges_.resize(vertexes_count_);
+  for (char symbol : alphabet_) {
+    AddEdge(new_start, new_start, symbol);
+  }
+  AddEdge(new_start, start_, kEps);
+  start_ = new_start;
+}
+
+std::vector<size_t> Automaton::GetMooreClasses() {
   std::vector<size_t> classes(vertexes_count_, 0);
   for (auto v : terminal_vertexes_) {
     classes[v] = 1;
@@ -577,13 +1078,16 @@ void Automaton::ToMCDFA() {
 
   size_t number_of_classes = 2;
   for (size_t i = 0; i < vertexes_count_; ++i) {
+    if (stats_ != nullptr) {
+      ++stats_->refinement_rounds;
+    }
     std::vector<EdgesForClasses> tmp_classes(vertexes_count_);
 
     for (size_t v = 0; v < vertexes_count_; ++v) {
       tmp_classes[v].first.first = classes[v];
       tmp_classes[v].second = v;
 
-      for (auto edge : edges_[v]) {
+      for (const auto& edge : edges_[v]) {
         char symbol = GetSymbolOfEdge(edge);
         for (size_t to : GetNeighborsOfEdge(edge)) {
           tmp_classes[v].first.second[symbol] = classes[to];
@@ -608,6 +1112,77 @@ void Automaton::ToMCDFA() {
     }
     number_of_classes = classes[tmp_classes[vertexes_count_ - 1].second] + 1;
   }
+  return classes;
+}
+
+void Automaton::GetTransitionTable(std::vector<size_t>& table,
+                                   std::vector<size_t>& initial_classes) const {
+  std::vector<int> symbol_index(256, -1);
+  for (size_t i = 0; i < alphabet_.size(); ++i) {
+    symbol_index[static_cast<unsigned char>(alphabet_[i])] = i;
+  }
+
+  const size_t symbols_count = alphabet_.size();
+  table.assign(vertexes_count_ * symbols_count, 0);
+  initial_classes.assign(vertexes_count_, 0);
+  for (size_t v = 0; v < vertexes_count_; ++v) {
+    for (const auto& edge : edges_[v]) {
+      int index = symbol_index[static_cast<unsigned char>(edge.first)];
+      table[v * symbols_count + index] = GetNeighborsOfEdge(edge)[0];
+    }
+  }
+  for (size_t v : terminal_vertexes_) {
+    initial_classes[v] = 1;
+  }
+}
+
+std::vector<size_t> Automaton::GetParallelMooreClasses(size_t threads_count) {
+  std::vector<size_t> table;
+  std::vector<size_t> initial_classes;
+  GetTransitionTable(table, initial_classes);
+
+  size_t rounds_count = 0;
+  std::vector<size_t> classes =
+      ParallelMooreClasses(table, alphabet_.size(), initial_classes,
+                           threads_count, &rounds_count);
+  if (stats_ != nullptr) {
+    stats_->refinement_rounds += rounds_count;
+  }
+  return classes;
+}
+
+std::vector<size_t> Automaton::GetHopcroftClasses() {
+  std::vector<size_t> table;
+  std::vector<size_t> initial_classes;
+  GetTransitionTable(table, initial_classes);
+
+  size_t rounds_count = 0;
+  std::vector<size_t> classes = HopcroftClasses(
+      table, alphabet_.size(), initial_classes, &rounds_count);
+  if (stats_ != nullptr) {
+    stats_->refinement_rounds += rounds_count;
+  }
+  return classes;
+}
+
+void Automaton::ToMCDFA(MinimizationAlgorithm algorithm,
+                        size_t threads_count) {
+  StageTimer timer(stats_, "ToMCDFA", *this);
+  ToCDFA(threads_count);
+  if (vertexes_count_ == 0) {
+    return;
+  }
+
+  std::vector<size_t> classes;
+  if (algorithm == MinimizationAlgorithm::kHopcroft) {
+    classes = GetHopcroftClasses();
+  } else if (threads_count > 1) {
+    classes = GetParallelMooreClasses(threads_count);
+  } else {
+    classes = GetMooreClasses();
+  }
+  size_t number_of_classes =
+      *std::max_element(classes.begin(), classes.end()) + 1;
 
   start_ = classes[start_];
 
@@ -631,7 +1206,7 @@ void Automaton::ToMCDFA() {
     }
 
     set_for_classes.insert(classes[v]);
-    for (auto edge : old_edges[v]) {
+    for (const auto& edge : old_edges[v]) {
       char symbol = GetSymbolOfEdge(edge);
       for (size_t to : GetNeighborsOfEdge(edge)) {
         AddEdge(classes[v], classes[to], symbol);
@@ -642,43 +1217,11 @@ void Automaton::ToMCDFA() {
 
 bool Automaton::IsSuffixByLetterFixLength(char symbol, size_t length) {
   ToMCDFA();
-
-  if (alphabet_.find(symbol) == -1) {
-    return false;
-  }
-
-  std::vector<std::vector<size_t>> dp(vertexes_count_);
-  for (size_t v = 0; v < vertexes_count_; ++v) {
-    dp[v].push_back(edges_[v][symbol][0]);
-  }
-
-  for (size_t i = 2, index = 0; i <= length; i <<= 1, ++index) {
-    for (size_t v = 0; v < vertexes_count_; ++v) {
-      dp[v].push_back(dp[dp[v][index]][index]);
-    }
-  }
-
-  for (size_t v = 0; v < vertexes_count_; ++v) {
-    size_t current_length = length;
-    size_t current_vertex = v;
-    size_t index = 0;
-    while (current_length != 0) {
-      if (current_length & 1) {
-        current_vertex = dp[current_vertex][index];
-      }
-      current_length >>= 1;
-      ++index;
-    }
-    if (terminal_vertexes_.count(current_vertex)) {
-      return true;
-    }
-  }
-
-  return false;
+  return SuffixQuery(DenseDFA(*this)).IsSuffixByLetterFixLength(symbol, length);
 }
 
 bool Automaton::IsSuffixByLetterFixLength(std::string str, char symbol,
                                           size_t length) {
-  Automaton automaton(str);
-  return automaton.IsSuffixByLetterFixLength(symbol, length);
+  return RegexCache::Global().Get(str)->IsSuffixByLetterFixLength(symbol,
+                                                                  length);
 }
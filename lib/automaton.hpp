@@ -1,21 +1,36 @@
+#pragma once
+
 #include <algorithm>
-#include <bitset>
 #include <cstddef>
 #include <iostream>
 #include <map>
 #include <queue>
 #include <set>
 #include <sstream>
-#include <stack>
 #include <unordered_map>
 #include <utility>
 #include <vector>
+#include "minimization.hpp"
+#include "subset_table.hpp"
 
-using Edge = std::pair<char, std::vector<size_t>>;
+using Edge = std::pair<const char, std::vector<size_t>>;
 using Edges = std::vector<std::unordered_map<char, std::vector<size_t>>>;
 using EdgesForClasses =
     std::pair<std::pair<size_t, std::map<char, size_t>>, size_t>;
 
+class ConcurrentSubsetTable;
+
+class CsrNFA;
+
+struct PipelineStats;
+
+enum class MinimizationAlgorithm { kHopcroft, kMoore };
+
+// Thompson gives an automaton with eps edges and about two vertexes per
+// token. Glushkov gives an automaton without eps edges and with one vertex
+// per occurrence of a letter plus the start.
+enum class RegexConstruction { kThompson, kGlushkov };
+
 class Automaton {
  private:
   struct EdgeHelper {
@@ -31,22 +46,22 @@ class Automaton {
 
  private:
   static constexpr char kEps = '1';
-  static constexpr size_t kMaxVertex = 1000;
 
   size_t start_;
   std::string alphabet_;
   size_t vertexes_count_;
   std::set<size_t> terminal_vertexes_;
   Edges edges_;
+  PipelineStats* stats_ = nullptr;
 
   static bool IsEps(const char symbol);
 
-  static char GetSymbolOfEdge(Edge edge);
+  static char GetSymbolOfEdge(const Edge& edge);
 
-  static const std::vector<size_t> GetNeighborsOfEdge(Edge edge);
+  static const std::vector<size_t>& GetNeighborsOfEdge(const Edge& edge);
 
   std::vector<EdgeHelper> GetEdgesList(
-      std::set<size_t> edges_to_remove = std::set<size_t>());
+      const std::vector<bool>& is_removed = std::vector<bool>());
 
   std::vector<size_t> GetCompressedList(const std::vector<EdgeHelper>& pairs);
 
@@ -61,9 +76,55 @@ class Automaton {
 
   void CompressAndAssignEdges(const std::vector<EdgeHelper>& pairs);
 
+  static std::vector<bool> GetReachableVertexes(
+      const std::vector<std::vector<size_t>>& adjacency,
+      const std::vector<size_t>& sources);
+
   void RemoveReachLessVertex();
 
-  bool GetBit(size_t mask, size_t pos);
+  // Eps-closures of the strongly connected components of the eps subgraph,
+  // component[v] is the component of the vertex v.
+  static std::vector<std::vector<size_t>> GetEpsClosures(
+      const CsrNFA& nfa, std::vector<size_t>& component);
+
+  // Sorted and deduplicated targets of the subset by every letter. Returns
+  // whether the subset contains a terminal vertex.
+  static bool GetSubsetTargets(const CsrNFA& nfa,
+                               const std::vector<int>& symbol_index,
+                               const SubsetTable::Subset& subset,
+                               std::vector<SubsetTable::Subset>& delta);
+
+  void ExploreSubsetsParallel(const CsrNFA& nfa,
+                              const std::vector<int>& symbol_index,
+                              size_t threads_count,
+                              ConcurrentSubsetTable& subsets,
+                              std::vector<EdgeHelper>& list,
+                              std::vector<size_t>& terms);
+
+  // Replaces the automaton with the one on the explored subsets, the subset
+  // with id 0 being the start.
+  void AssignSubsetAutomaton(
+      const std::vector<const SubsetTable::Subset*>& subsets,
+      std::vector<EdgeHelper>& list, const std::vector<size_t>& terms);
+
+  // Flat transition table of the complete DFA, where table[v * k + i] is the
+  // target by the i-th letter of the alphabet, and the terminal classes.
+  void GetTransitionTable(std::vector<size_t>& table,
+                          std::vector<size_t>& initial_classes) const;
+
+  void BuildThompson(const std::string& regex);
+
+  // Appends the edges of the other automaton with its vertexes shifted, a
+  // whole vertex at a time. The alphabet is left to the caller.
+  void AppendEdges(const Automaton& other, size_t shift);
+
+  void BuildGlushkov(const std::string& regex);
+
+  std::vector<size_t> GetMooreClasses();
+
+  std::vector<size_t> GetParallelMooreClasses(size_t threads_count);
+
+  std::vector<size_t> GetHopcroftClasses();
 
   std::string UnionStrings(std::string first, std::string second);
 
@@ -72,30 +133,68 @@ class Automaton {
 
   explicit Automaton(const char symbol);
 
-  explicit Automaton(const std::string& regex);
+  explicit Automaton(const std::string& regex,
+                     PipelineStats* stats = nullptr);
+
+  Automaton(const std::string& regex, RegexConstruction construction,
+            PipelineStats* stats = nullptr);
 
   size_t GetVertexCount() const;
 
+  size_t GetEdgeCount() const;
+
   std::string GetAlphabet() const;
 
+  // Approximate number of bytes held by the vertexes and the edges.
+  size_t GetMemoryUsage() const;
+
+  // Every following stage appends its statistics to the sink, nullptr turns
+  // them off. The pointer is copied together with the automaton.
+  void SetStats(PipelineStats* stats);
+
+  // Adds the symbol to the alphabet if it is a new letter.
   void AddEdge(size_t from, size_t to, char symbol);
 
   void RemoveEpsEdges();
 
-  void ToDFA();  // Deterministic Finite Automaton
+  // Deterministic Finite Automaton. With more than one thread the subsets are
+  // explored in parallel; the result is the same as with one thread.
+  void ToDFA(size_t threads_count = 1);
 
-  void ToCDFA();  // Complete Deterministic Finite Automaton
+  // Complete Deterministic Finite Automaton
+  void ToCDFA(size_t threads_count = 1);
 
-  void ToMCDFA();  // Minimal Complete Deterministic Finite Automaton
+  // Minimal Complete Deterministic Finite Automaton. The threads are used by
+  // ToDFA and by the Moore refinement, Hopcroft runs on one thread. The
+  // result does not depend on the number of threads.
+  void ToMCDFA(
+      MinimizationAlgorithm algorithm = MinimizationAlgorithm::kHopcroft,
+      size_t threads_count = 1);
 
   void
   AdditionToMCDFA();  // Addition to Minimal Complete Deterministic Finite Automaton
 
+  // Automaton of the reversed words, with eps edges.
+  void Reverse();
+
+  // Automaton of the words with a suffix in the language, i.e. of A*L where A
+  // is the alphabet. Adds eps edges.
+  void AddAnyPrefix();
+
   bool IsSuffixByLetterFixLength(char symbol, size_t length);
 
+  // The compiled regex is kept in RegexCache::Global().
   static bool IsSuffixByLetterFixLength(std::string str, char symbol,
                                         size_t length);
 
+  friend class AutomatonParser;
+
+  friend class CsrNFA;
+
+  friend class DerivativeDFA;
+
+  friend class DenseDFA;
+
   friend Automaton operator+(const Automaton& first, const Automaton& second);
 
   friend Automaton operator-(const Automaton& first, const Automaton& second);
@@ -0,0 +1,118 @@
+#include "automaton_parser.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "mapped_file.hpp"
+
+namespace {
+
+class Cursor {
+ private:
+  const char* current_;
+  const char* end_;
+
+ public:
+  explicit Cursor(std::string_view text)
+      : current_(text.data()), end_(text.data() + text.size()) {}
+
+  bool AtEnd() const { return current_ == end_; }
+
+  // Whether the current line is empty, i.e. the line loop of operator>> stops.
+  bool AtEmptyLine() const { return AtEnd() || *current_ == '\n'; }
+
+  void SkipSpaces() {
+    while (current_ != end_ && *current_ != '\n' &&
+           (*current_ == ' ' || *current_ == '\t' || *current_ == '\r' ||
+            *current_ == '\v' || *current_ == '\f')) {
+      ++current_;
+    }
+  }
+
+  void SkipLine() {
+    while (current_ != end_ && *current_++ != '\n') {
+    }
+  }
+
+  size_t ReadNumber() {
+    SkipSpaces();
+    if (AtEnd() || *current_ < '0' || *current_ > '9') {
+      throw std::runtime_error("Incorrect automaton file");
+    }
+    size_t number = 0;
+    while (current_ != end_ && *current_ >= '0' && *current_ <= '9') {
+      const size_t digit = *current_++ - '0';
+      if (number > (std::numeric_limits<size_t>::max() - digit) / 10) {
+        throw std::runtime_error("Incorrect automaton file");
+      }
+      number = number * 10 + digit;
+    }
+    return number;
+  }
+
+  char ReadSymbol() {
+    SkipSpaces();
+    if (AtEmptyLine()) {
+      throw std::runtime_error("Incorrect automaton file");
+    }
+    return *current_++;
+  }
+};
+
+}  // namespace
+
+Automaton AutomatonParser::Parse(std::string_view text) {
+  Automaton automaton;
+  Cursor cursor(text);
+
+  // The start may be preceded by empty lines, as operator>> skips them.
+  while (!cursor.AtEnd()) {
+    cursor.SkipSpaces();
+    if (!cursor.AtEmptyLine()) {
+      break;
+    }
+    cursor.SkipLine();
+  }
+  automaton.start_ = cursor.ReadNumber();
+  size_t max_vertex = automaton.start_;
+  cursor.SkipLine();
+  cursor.SkipLine();
+
+  while (!cursor.AtEmptyLine()) {
+    size_t term = cursor.ReadNumber();
+    automaton.terminal_vertexes_.insert(term);
+    max_vertex = std::max(max_vertex, term);
+    cursor.SkipLine();
+  }
+  cursor.SkipLine();
+
+  // Lines are at least 6 bytes long, e.g. "0 1 a\n".
+  std::vector<Automaton::EdgeHelper> edges;
+  edges.reserve(text.size() / 6);
+  while (!cursor.AtEmptyLine()) {
+    size_t from = cursor.ReadNumber();
+    size_t to = cursor.ReadNumber();
+    char symbol = cursor.ReadSymbol();
+    cursor.SkipLine();
+    edges.emplace_back(from, to, symbol);
+    max_vertex = std::max({max_vertex, from, to});
+  }
+
+  // One huge number must not make the automaton allocate for all vertexes
+  // up to it, nor wrap the count around.
+  if (max_vertex >= kMaxVertexCount) {
+    throw std::runtime_error("Incorrect automaton file");
+  }
+  automaton.vertexes_count_ = max_vertex + 1;
+  automaton.edges_.resize(automaton.vertexes_count_);
+  // AddEdge collects the alphabet.
+  for (const Automaton::EdgeHelper& edge : edges) {
+    automaton.AddEdge(edge.from, edge.to, edge.symbol);
+  }
+  return automaton;
+}
+
+Automaton AutomatonParser::ParseFile(const std::string& path) {
+  MappedFile file(path);
+  return Parse(std::string_view(file.GetData(), file.GetSize()));
+}
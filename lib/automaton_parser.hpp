@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "automaton.hpp"
+
+// Reader of the text format of operator>> that parses the whole input in one
+// pass over a buffer. For a well-formed input the result is the same as
+// reading it with operator>> into an empty automaton; broken lines throw
+// std::runtime_error instead of being read partially, and so do vertex
+// numbers of kMaxVertexCount and more.
+class AutomatonParser {
+ public:
+  static constexpr size_t kMaxVertexCount = size_t{1} << 24;
+
+  static Automaton Parse(std::string_view text);
+
+  // The file is mapped into memory instead of being read.
+  static Automaton ParseFile(const std::string& path);
+};
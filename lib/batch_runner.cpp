@@ -0,0 +1,347 @@
+#include "batch_runner.hpp"
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define AUTOMATON_X86_KERNELS
+#endif
+
+namespace {
+
+constexpr size_t kNoWord = std::numeric_limits<size_t>::max();
+
+// Bytes every lane loads with one gather.
+constexpr size_t kBlockSize = 4;
+
+// Words currently held by the lanes. A lane is busy while it has a word.
+// An idle lane reads the bytes of a busy one, so kernels need no masks, and
+// its state is ignored.
+template <size_t kLanesCount>
+class Lanes {
+ public:
+  const char* positions[kLanesCount];
+  size_t remaining[kLanesCount];
+  size_t words[kLanesCount];
+  uint32_t states[kLanesCount];
+
+ private:
+  std::span<const std::string_view> input_;
+  std::span<const size_t> order_;
+  uint32_t* results_;
+  uint32_t start_;
+  size_t next_ = 0;
+
+ public:
+  // Words are taken in the given order, none of them may be empty.
+  Lanes(std::span<const std::string_view> input, std::span<const size_t> order,
+        uint32_t start, uint32_t* results)
+      : input_(input), order_(order), results_(results), start_(start) {
+    std::fill(std::begin(positions), std::end(positions), nullptr);
+    std::fill(std::begin(remaining), std::end(remaining), 0);
+    std::fill(std::begin(words), std::end(words), kNoWord);
+    std::fill(std::begin(states), std::end(states), start);
+  }
+
+  // Stores the results of the finished words and gives their lanes the next
+  // ones. Returns the number of steps all busy lanes can make without
+  // running out of their words, 0 if no lane is busy.
+  size_t Refill() {
+    size_t steps = kNoWord;
+    size_t busy_lane = kNoWord;
+    for (size_t lane = 0; lane < kLanesCount; ++lane) {
+      if (remaining[lane] == 0) {
+        if (words[lane] != kNoWord) {
+          results_[words[lane]] = states[lane];
+          words[lane] = kNoWord;
+        }
+        if (next_ < order_.size()) {
+          words[lane] = order_[next_++];
+          positions[lane] = input_[words[lane]].data();
+          remaining[lane] = input_[words[lane]].size();
+          states[lane] = start_;
+        }
+      }
+      if (words[lane] != kNoWord) {
+        steps = std::min(steps, remaining[lane]);
+        busy_lane = lane;
+      }
+    }
+    if (busy_lane == kNoWord) {
+      return 0;
+    }
+    for (size_t lane = 0; lane < kLanesCount; ++lane) {
+      if (words[lane] == kNoWord) {
+        positions[lane] = positions[busy_lane];
+      }
+    }
+    return steps;
+  }
+
+  void Advance(size_t steps) {
+    for (size_t lane = 0; lane < kLanesCount; ++lane) {
+      if (words[lane] != kNoWord) {
+        positions[lane] += steps;
+        remaining[lane] -= steps;
+      }
+    }
+  }
+};
+
+void RunScalar(const uint32_t* table, const uint32_t* symbol_index,
+               Lanes<8>& lanes) {
+  for (size_t steps = lanes.Refill(); steps != 0; steps = lanes.Refill()) {
+    uint32_t states[8];
+    std::copy(std::begin(lanes.states), std::end(lanes.states), states);
+    for (size_t i = 0; i < steps; ++i) {
+      for (size_t lane = 0; lane < 8; ++lane) {
+        const auto symbol =
+            static_cast<unsigned char>(lanes.positions[lane][i]);
+        states[lane] = table[states[lane] + symbol_index[symbol]];
+      }
+    }
+    std::copy(std::begin(states), std::end(states), lanes.states);
+    lanes.Advance(steps);
+  }
+}
+
+#ifdef AUTOMATON_X86_KERNELS
+
+// Two independent vectors of 8 lanes hide the latency of the gathers.
+__attribute__((target("avx2"))) void RunAvx2(const uint32_t* table,
+                                             const uint32_t* symbol_index,
+                                             Lanes<16>& lanes) {
+  const int* table_data = reinterpret_cast<const int*>(table);
+  const int* symbol_data = reinterpret_cast<const int*>(symbol_index);
+  const __m256i byte_mask = _mm256_set1_epi32(0xff);
+  const __m256i block_size = _mm256_set1_epi64x(kBlockSize);
+
+  for (size_t steps = lanes.Refill(); steps != 0; steps = lanes.Refill()) {
+    __m256i positions[4];
+    for (size_t k = 0; k < 4; ++k) {
+      positions[k] = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(lanes.positions + 4 * k));
+    }
+    __m256i first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes.states));
+    __m256i second = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(lanes.states + 8));
+
+    size_t i = 0;
+    for (; i + kBlockSize <= steps; i += kBlockSize) {
+      __m256i first_block =
+          _mm256_set_m128i(_mm256_i64gather_epi32(nullptr, positions[1], 1),
+                           _mm256_i64gather_epi32(nullptr, positions[0], 1));
+      __m256i second_block =
+          _mm256_set_m128i(_mm256_i64gather_epi32(nullptr, positions[3], 1),
+                           _mm256_i64gather_epi32(nullptr, positions[2], 1));
+      for (size_t k = 0; k < 4; ++k) {
+        positions[k] = _mm256_add_epi64(positions[k], block_size);
+      }
+      for (size_t j = 0; j < kBlockSize; ++j) {
+        const __m256i first_column = _mm256_i32gather_epi32(
+            symbol_data, _mm256_and_si256(first_block, byte_mask), 4);
+        const __m256i second_column = _mm256_i32gather_epi32(
+            symbol_data, _mm256_and_si256(second_block, byte_mask), 4);
+        first = _mm256_i32gather_epi32(
+            table_data, _mm256_add_epi32(first, first_column), 4);
+        second = _mm256_i32gather_epi32(
+            table_data, _mm256_add_epi32(second, second_column), 4);
+        first_block = _mm256_srli_epi32(first_block, 8);
+        second_block = _mm256_srli_epi32(second_block, 8);
+      }
+    }
+    for (; i < steps; ++i) {
+      alignas(32) int symbols[16];
+      for (size_t lane = 0; lane < 16; ++lane) {
+        symbols[lane] = static_cast<unsigned char>(lanes.positions[lane][i]);
+      }
+      const __m256i first_column = _mm256_i32gather_epi32(
+          symbol_data,
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(symbols)), 4);
+      const __m256i second_column = _mm256_i32gather_epi32(
+          symbol_data,
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(symbols + 8)), 4);
+      first = _mm256_i32gather_epi32(
+          table_data, _mm256_add_epi32(first, first_column), 4);
+      second = _mm256_i32gather_epi32(
+          table_data, _mm256_add_epi32(second, second_column), 4);
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.states), first);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.states + 8), second);
+    lanes.Advance(steps);
+  }
+}
+
+// Two independent vectors of 16 lanes hide the latency of the gathers.
+__attribute__((target("avx512f"))) void RunAvx512(
+    const uint32_t* table, const uint32_t* symbol_index, Lanes<32>& lanes) {
+  const __m512i byte_mask = _mm512_set1_epi32(0xff);
+  const __m512i block_size = _mm512_set1_epi64(kBlockSize);
+
+  for (size_t steps = lanes.Refill(); steps != 0; steps = lanes.Refill()) {
+    __m512i positions[4];
+    for (size_t k = 0; k < 4; ++k) {
+      positions[k] = _mm512_loadu_si512(lanes.positions + 8 * k);
+    }
+    __m512i first = _mm512_loadu_si512(lanes.states);
+    __m512i second = _mm512_loadu_si512(lanes.states + 16);
+
+    size_t i = 0;
+    for (; i + kBlockSize <= steps; i += kBlockSize) {
+      __m512i first_block = _mm512_inserti64x4(
+          _mm512_castsi256_si512(
+              _mm512_i64gather_epi32(positions[0], nullptr, 1)),
+          _mm512_i64gather_epi32(positions[1], nullptr, 1), 1);
+      __m512i second_block = _mm512_inserti64x4(
+          _mm512_castsi256_si512(
+              _mm512_i64gather_epi32(positions[2], nullptr, 1)),
+          _mm512_i64gather_epi32(positions[3], nullptr, 1), 1);
+      for (size_t k = 0; k < 4; ++k) {
+        positions[k] = _mm512_add_epi64(positions[k], block_size);
+      }
+      for (size_t j = 0; j < kBlockSize; ++j) {
+        const __m512i first_column = _mm512_i32gather_epi32(
+            _mm512_and_si512(first_block, byte_mask), symbol_index, 4);
+        const __m512i second_column = _mm512_i32gather_epi32(
+            _mm512_and_si512(second_block, byte_mask), symbol_index, 4);
+        first = _mm512_i32gather_epi32(_mm512_add_epi32(first, first_column),
+                                       table, 4);
+        second = _mm512_i32gather_epi32(
+            _mm512_add_epi32(second, second_column), table, 4);
+        first_block = _mm512_srli_epi32(first_block, 8);
+        second_block = _mm512_srli_epi32(second_block, 8);
+      }
+    }
+    for (; i < steps; ++i) {
+      alignas(64) int symbols[32];
+      for (size_t lane = 0; lane < 32; ++lane) {
+        symbols[lane] = static_cast<unsigned char>(lanes.positions[lane][i]);
+      }
+      const __m512i first_column = _mm512_i32gather_epi32(
+          _mm512_load_si512(symbols), symbol_index, 4);
+      const __m512i second_column = _mm512_i32gather_epi32(
+          _mm512_load_si512(symbols + 16), symbol_index, 4);
+      first = _mm512_i32gather_epi32(_mm512_add_epi32(first, first_column),
+                                     table, 4);
+      second = _mm512_i32gather_epi32(_mm512_add_epi32(second, second_column),
+                                      table, 4);
+    }
+
+    _mm512_storeu_si512(lanes.states, first);
+    _mm512_storeu_si512(lanes.states + 16, second);
+    lanes.Advance(steps);
+  }
+}
+
+#endif
+
+}  // namespace
+
+BatchRunner::BatchRunner(const DenseDFA& dfa, SimdLevel level)
+    : level_(level),
+      start_(dfa.GetStart() * dfa.GetColumnCount()),
+      columns_count_(dfa.GetColumnCount()),
+      symbol_index_(dfa.GetSymbolIndexes()),
+      table_(dfa.GetTable()),
+      is_terminal_(dfa.GetStateCount()) {
+  if (!IsSupported(level_)) {
+    throw std::runtime_error("SIMD level is not supported by the processor");
+  }
+  // Premultiplied targets must fit into 32 bits.
+  if (table_.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Automaton is too large for BatchRunner");
+  }
+  // Gathers take signed 32-bit indexes.
+  if (level_ != SimdLevel::kScalar &&
+      table_.size() > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    level_ = SimdLevel::kScalar;
+  }
+  for (uint32_t& to : table_) {
+    to *= columns_count_;
+  }
+  for (uint32_t state = 0; state < dfa.GetStateCount(); ++state) {
+    is_terminal_[state] = dfa.IsTerminal(state);
+  }
+}
+
+std::vector<uint32_t> BatchRunner::Run(
+    std::span<const std::string_view> words) const {
+  std::vector<uint32_t> states(words.size());
+  std::vector<size_t> long_words;
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (words[i].size() < kShortWordLength) {
+      uint32_t state = start_;
+      for (char symbol : words[i]) {
+        state = table_[state + symbol_index_[static_cast<unsigned char>(
+                                   symbol)]];
+      }
+      states[i] = state;
+    } else {
+      long_words.push_back(i);
+    }
+  }
+
+  switch (level_) {
+#ifdef AUTOMATON_X86_KERNELS
+    case SimdLevel::kAvx512: {
+      Lanes<32> lanes(words, long_words, start_, states.data());
+      RunAvx512(table_.data(), symbol_index_.data(), lanes);
+      break;
+    }
+    case SimdLevel::kAvx2: {
+      Lanes<16> lanes(words, long_words, start_, states.data());
+      RunAvx2(table_.data(), symbol_index_.data(), lanes);
+      break;
+    }
+#endif
+    default: {
+      Lanes<8> lanes(words, long_words, start_, states.data());
+      RunScalar(table_.data(), symbol_index_.data(), lanes);
+      break;
+    }
+  }
+
+  for (uint32_t& state : states) {
+    state /= columns_count_;
+  }
+  return states;
+}
+
+std::vector<bool> BatchRunner::Accepts(
+    std::span<const std::string_view> words) const {
+  std::vector<uint32_t> states = Run(words);
+  std::vector<bool> result(states.size());
+  for (size_t i = 0; i < states.size(); ++i) {
+    result[i] = is_terminal_[states[i]];
+  }
+  return result;
+}
+
+bool BatchRunner::IsSupported(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::kScalar:
+      return true;
+#ifdef AUTOMATON_X86_KERNELS
+    case SimdLevel::kAvx2:
+      return __builtin_cpu_supports("avx2");
+    case SimdLevel::kAvx512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+BatchRunner::SimdLevel BatchRunner::GetBestLevel() {
+  if (IsSupported(SimdLevel::kAvx512)) {
+    return SimdLevel::kAvx512;
+  }
+  if (IsSupported(SimdLevel::kAvx2)) {
+    return SimdLevel::kAvx2;
+  }
+  return SimdLevel::kScalar;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "dense_dfa.hpp"
+
+// Runs many independent words through one complete DFA. A single walk is a
+// chain of dependent loads, so long words are run in lanes: every lane holds
+// its own word and all lanes make a step together, with the table lookups of
+// a step done by one SIMD gather. A lane that finishes its word takes the
+// next one, lanes left without words repeat the reads of a busy lane and are
+// ignored. Short words are run one by one, the processor already overlaps
+// their walks.
+class BatchRunner {
+ public:
+  enum class SimdLevel {
+    kScalar,  // lanes interleaved by hand, works everywhere
+    kAvx2,
+    kAvx512,
+  };
+
+ private:
+  // Words shorter than this are not put into the lanes.
+  static constexpr size_t kShortWordLength = 32;
+
+  SimdLevel level_;
+  uint32_t start_ = 0;
+  uint32_t columns_count_ = 0;
+  std::array<uint32_t, 256> symbol_index_{};
+  // Transitions of the DFA with every target premultiplied by the number of
+  // columns, so a step is one addition and one load.
+  std::vector<uint32_t> table_;
+  std::vector<bool> is_terminal_;
+
+ public:
+  // Throws std::runtime_error if the level is not supported by the
+  // processor or if the premultiplied targets do not fit into 32 bits, i.e.
+  // the table has more than 2^32 - 1 cells.
+  explicit BatchRunner(const DenseDFA& dfa, SimdLevel level = GetBestLevel());
+
+  SimdLevel GetLevel() const { return level_; }
+
+  // States of the DFA reached from the start after reading every word.
+  std::vector<uint32_t> Run(std::span<const std::string_view> words) const;
+
+  std::vector<bool> Accepts(std::span<const std::string_view> words) const;
+
+  static bool IsSupported(SimdLevel level);
+
+  // The widest level supported by the processor.
+  static SimdLevel GetBestLevel();
+};
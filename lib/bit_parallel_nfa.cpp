@@ -0,0 +1,103 @@
+#include "bit_parallel_nfa.hpp"
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+
+CsrNFA GetEpsFreeNFA(Automaton automaton) {
+  automaton.RemoveEpsEdges();
+  return CsrNFA(automaton);
+}
+
+}  // namespace
+
+BitParallelNFA::BitParallelNFA(const Automaton& automaton)
+    : BitParallelNFA(GetEpsFreeNFA(automaton)) {}
+
+BitParallelNFA::BitParallelNFA(const CsrNFA& nfa) {
+  vertexes_count_ = nfa.GetVertexCount();
+  if (vertexes_count_ > kMaxVertexCount) {
+    throw std::runtime_error("Automaton is too large for BitParallelNFA");
+  }
+  alphabet_ = nfa.GetAlphabet();
+  chunks_count_ = (vertexes_count_ + kChunkSize - 1) / kChunkSize;
+  const size_t n = vertexes_count_;
+
+  // The symbol of the edges into every vertex, -1 if there are none.
+  std::vector<int> entering(n, -1);
+  for (size_t v = 0; v < n; ++v) {
+    for (size_t e = nfa.EdgesBegin(v); e < nfa.EdgesEnd(v); ++e) {
+      const int symbol = static_cast<unsigned char>(nfa.GetSymbol(e));
+      int& entering_symbol = entering[nfa.GetTarget(e)];
+      if (entering_symbol != -1 && entering_symbol != symbol) {
+        is_homogeneous_ = false;
+      }
+      entering_symbol = symbol;
+    }
+  }
+
+  const size_t tables_count = is_homogeneous_ ? 1 : alphabet_.size();
+  for (size_t i = 0; i < alphabet_.size(); ++i) {
+    const auto byte = static_cast<unsigned char>(alphabet_[i]);
+    table_of_symbol_[byte] = is_homogeneous_ ? 0 : i;
+    mask_of_symbol_[byte] = is_homogeneous_ ? 0 : ~uint64_t{0};
+  }
+
+  std::vector<uint64_t> targets(tables_count * n, 0);
+  for (size_t v = 0; v < n; ++v) {
+    if (is_homogeneous_ && entering[v] != -1) {
+      mask_of_symbol_[entering[v]] |= uint64_t{1} << v;
+    }
+    if (nfa.IsTerminal(v)) {
+      terminal_ |= uint64_t{1} << v;
+    }
+    for (size_t e = nfa.EdgesBegin(v); e < nfa.EdgesEnd(v); ++e) {
+      const auto byte = static_cast<unsigned char>(nfa.GetSymbol(e));
+      targets[table_of_symbol_[byte] * n + v] |= uint64_t{1}
+                                                 << nfa.GetTarget(e);
+    }
+  }
+
+  // The union for a byte is the union for the byte without its lowest bit
+  // plus the targets of the vertex of that bit.
+  tables_.assign(tables_count * chunks_count_ * 256, 0);
+  for (size_t t = 0; t < tables_count; ++t) {
+    for (size_t chunk = 0; chunk < chunks_count_; ++chunk) {
+      uint64_t* table = tables_.data() + (t * chunks_count_ + chunk) * 256;
+      for (size_t byte = 1; byte < 256; ++byte) {
+        const size_t v = chunk * kChunkSize + __builtin_ctz(byte);
+        table[byte] =
+            table[byte & (byte - 1)] | (v < n ? targets[t * n + v] : 0);
+      }
+    }
+  }
+
+  if (n != 0) {
+    start_ = uint64_t{1} << nfa.GetStart();
+  }
+}
+
+uint64_t BitParallelNFA::Run(std::string_view word) const {
+  uint64_t set = start_;
+  for (size_t i = 0; i < word.size() && set != 0; ++i) {
+    set = Next(set, word[i]);
+  }
+  return set;
+}
+
+size_t BitParallelNFA::CountReachableSets(size_t limit) const {
+  std::unordered_set<uint64_t> seen = {start_};
+  std::vector<uint64_t> queue = {start_};
+  for (size_t i = 0; i < queue.size(); ++i) {
+    for (char symbol : alphabet_) {
+      const uint64_t next = Next(queue[i], symbol);
+      if (seen.insert(next).second) {
+        if (seen.size() > limit) {
+          return limit + 1;
+        }
+        queue.push_back(next);
+      }
+    }
+  }
+  return seen.size();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "automaton.hpp"
+#include "csr_nfa.hpp"
+
+// Simulation of the eps-free automaton with the set of current vertexes kept
+// in one 64-bit word. A step takes the union of the targets of the set byte
+// by byte from precomputed tables, so it costs one lookup per 8 vertexes
+// whatever the set is. If all edges into a vertex have the same symbol, as
+// after the Glushkov construction, the tables do not depend on the symbol and
+// the step ends with the mask of the vertexes entered by it. Otherwise there
+// is a table for every letter.
+class BitParallelNFA {
+ private:
+  static constexpr size_t kChunkSize = 8;  // bits
+
+  uint64_t start_ = 0;
+  uint64_t terminal_ = 0;
+  size_t vertexes_count_ = 0;
+  size_t chunks_count_ = 0;
+  bool is_homogeneous_ = true;
+  std::string alphabet_;
+  std::array<uint32_t, 256> table_of_symbol_{};
+  std::array<uint64_t, 256> mask_of_symbol_{};
+  // tables_[(t * chunks_count_ + chunk) * 256 + byte] is the union of the
+  // targets in the t-th table of the vertexes in that byte of the set.
+  std::vector<uint64_t> tables_;
+
+ public:
+  static constexpr size_t kMaxVertexCount = 64;
+
+  // Throws std::runtime_error if the eps-free automaton has more than
+  // kMaxVertexCount vertexes.
+  explicit BitParallelNFA(const Automaton& automaton);
+
+  // The automaton must have no eps edges.
+  explicit BitParallelNFA(const CsrNFA& nfa);
+
+  size_t GetVertexCount() const { return vertexes_count_; }
+
+  bool IsHomogeneous() const { return is_homogeneous_; }
+
+  uint64_t GetStart() const { return start_; }
+
+  bool IsTerminal(uint64_t set) const { return (set & terminal_) != 0; }
+
+  uint64_t Next(uint64_t set, char symbol) const {
+    const auto byte = static_cast<unsigned char>(symbol);
+    const uint64_t* table =
+        tables_.data() + table_of_symbol_[byte] * chunks_count_ * 256;
+    uint64_t next = 0;
+    for (size_t chunk = 0; chunk < chunks_count_; ++chunk) {
+      next |= table[chunk * 256 + ((set >> (chunk * kChunkSize)) & 0xff)];
+    }
+    return next & mask_of_symbol_[byte];
+  }
+
+  // Set reached from the start after reading the word. Stops once the set
+  // gets empty.
+  uint64_t Run(std::string_view word) const;
+
+  bool Accepts(std::string_view word) const { return IsTerminal(Run(word)); }
+
+  // Number of sets reachable from the start by the letters, i.e. of states
+  // of the DFA before the minimization. Stops counting after limit + 1.
+  size_t CountReachableSets(size_t limit) const;
+};
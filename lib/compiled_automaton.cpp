@@ -0,0 +1,19 @@
+#include "compiled_automaton.hpp"
+#include <utility>
+
+namespace {
+
+Automaton Minimize(Automaton automaton) {
+  automaton.ToMCDFA();
+  return automaton;
+}
+
+}  // namespace
+
+CompiledAutomaton::CompiledAutomaton(Automaton automaton)
+    : dfa_(Minimize(std::move(automaton))),
+      suffix_query_(dfa_),
+      batch_runner_(dfa_) {}
+
+CompiledAutomaton::CompiledAutomaton(const std::string& regex)
+    : CompiledAutomaton(Automaton(regex)) {}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "automaton.hpp"
+#include "batch_runner.hpp"
+#include "dense_dfa.hpp"
+#include "suffix_query.hpp"
+
+// Minimal complete DFA frozen for queries. Nothing is changed after the
+// constructor, so one object can be shared by any number of threads without
+// locks.
+class CompiledAutomaton {
+ private:
+  DenseDFA dfa_;
+  SuffixQuery suffix_query_;
+  BatchRunner batch_runner_;
+
+ public:
+  // Minimizes a copy of the automaton.
+  explicit CompiledAutomaton(Automaton automaton);
+
+  // Regex in reverse Polish notation.
+  explicit CompiledAutomaton(const std::string& regex);
+
+  const DenseDFA& GetDFA() const { return dfa_; }
+
+  bool Accepts(std::string_view word) const { return dfa_.Accepts(word); }
+
+  std::vector<bool> Accepts(std::span<const std::string_view> words) const {
+    return batch_runner_.Accepts(words);
+  }
+
+  bool IsSuffixByLetterFixLength(char symbol, size_t length) const {
+    return suffix_query_.IsSuffixByLetterFixLength(symbol, length);
+  }
+
+  std::vector<bool> IsSuffixByLetterFixLength(
+      char symbol, std::span<const size_t> lengths) const {
+    return suffix_query_.IsSuffixByLetterFixLength(symbol, lengths);
+  }
+};
@@ -0,0 +1,30 @@
+#include "concurrent_subset_table.hpp"
+#include <utility>
+
+ConcurrentSubsetTable::ConcurrentSubsetTable() : shards_(kShardsCount) {}
+
+ConcurrentSubsetTable::InsertResult ConcurrentSubsetTable::Insert(
+    Subset subset) {
+  size_t hash = SubsetTable::SubsetHash()(subset);
+  // The low bits choose the bucket inside the shard, so take the high ones.
+  Shard& shard = shards_[(hash >> 32) % kShardsCount];
+
+  std::lock_guard lock(shard.mutex);
+  auto it = shard.ids.find(subset);
+  if (it != shard.ids.end()) {
+    return {it->second, false, &it->first};
+  }
+  it = shard.ids.emplace(std::move(subset), size_++).first;
+  return {it->second, true, &it->first};
+}
+
+std::vector<const ConcurrentSubsetTable::Subset*>
+ConcurrentSubsetTable::GetSubsets() const {
+  std::vector<const Subset*> subsets(size_);
+  for (const Shard& shard : shards_) {
+    for (const auto& [subset, id] : shard.ids) {
+      subsets[id] = &subset;
+    }
+  }
+  return subsets;
+}
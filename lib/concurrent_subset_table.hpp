@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "subset_table.hpp"
+
+// SubsetTable that many threads can fill at once. Subsets are spread over
+// shards by their hash, every shard has its own lock, and ids are taken from
+// one atomic counter, so they depend on the order of the insertions.
+class ConcurrentSubsetTable {
+ public:
+  using Subset = SubsetTable::Subset;
+
+  struct InsertResult {
+    size_t id;
+    bool inserted;
+    const Subset* subset;  // stays valid while the table lives
+  };
+
+ private:
+  static constexpr size_t kShardsCount = 64;
+
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<Subset, size_t, SubsetTable::SubsetHash> ids;
+  };
+
+  std::vector<Shard> shards_;
+  std::atomic<size_t> size_ = 0;
+
+ public:
+  ConcurrentSubsetTable();
+
+  InsertResult Insert(Subset subset);
+
+  size_t Size() const { return size_; }
+
+  // Subsets indexed by their ids. Must not run concurrently with Insert().
+  std::vector<const Subset*> GetSubsets() const;
+};
@@ -0,0 +1,42 @@
+#include "csr_nfa.hpp"
+#include <algorithm>
+
+CsrNFA::CsrNFA(const Automaton& automaton)
+    : start_(automaton.start_),
+      vertexes_count_(automaton.vertexes_count_),
+      alphabet_(automaton.alphabet_),
+      offsets_(automaton.vertexes_count_ + 1, 0),
+      is_terminal_(automaton.vertexes_count_, false) {
+  size_t edges_count = 0;
+  for (size_t v = 0; v < vertexes_count_; ++v) {
+    for (const auto& edge : automaton.edges_[v]) {
+      edges_count += Automaton::GetNeighborsOfEdge(edge).size();
+    }
+  }
+  symbols_.reserve(edges_count);
+  targets_.reserve(edges_count);
+
+  std::vector<const Edge*> sorted;
+  for (size_t v = 0; v < vertexes_count_; ++v) {
+    sorted.clear();
+    for (const auto& edge : automaton.edges_[v]) {
+      sorted.push_back(&edge);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const Edge* first, const Edge* second) {
+                return first->first < second->first;
+              });
+
+    for (const Edge* edge : sorted) {
+      for (size_t to : Automaton::GetNeighborsOfEdge(*edge)) {
+        symbols_.push_back(Automaton::GetSymbolOfEdge(*edge));
+        targets_.push_back(to);
+      }
+    }
+    offsets_[v + 1] = targets_.size();
+  }
+
+  for (size_t v : automaton.terminal_vertexes_) {
+    is_terminal_[v] = true;
+  }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "automaton.hpp"
+
+// Frozen automaton in compressed sparse row layout. Edges of vertex v are
+// [EdgesBegin(v), EdgesEnd(v)), grouped by symbol; targets of one symbol keep
+// the order they had in the Automaton.
+class CsrNFA {
+ private:
+  size_t start_ = 0;
+  size_t vertexes_count_ = 0;
+  std::string alphabet_;
+  std::vector<size_t> offsets_;
+  std::vector<char> symbols_;
+  std::vector<size_t> targets_;
+  std::vector<bool> is_terminal_;
+
+ public:
+  CsrNFA() = default;
+
+  explicit CsrNFA(const Automaton& automaton);
+
+  size_t GetStart() const { return start_; }
+
+  size_t GetVertexCount() const { return vertexes_count_; }
+
+  size_t GetEdgeCount() const { return targets_.size(); }
+
+  const std::string& GetAlphabet() const { return alphabet_; }
+
+  size_t EdgesBegin(size_t v) const { return offsets_[v]; }
+
+  size_t EdgesEnd(size_t v) const { return offsets_[v + 1]; }
+
+  char GetSymbol(size_t edge) const { return symbols_[edge]; }
+
+  size_t GetTarget(size_t edge) const { return targets_[edge]; }
+
+  bool IsTerminal(size_t v) const { return is_terminal_[v]; }
+};
@@ -0,0 +1,152 @@
+#include "dense_dfa.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "dfa_file.hpp"
+
+DenseDFA::DenseDFA(const Automaton& automaton) {
+  alphabet_ = automaton.alphabet_;
+  const uint32_t symbols_count = alphabet_.size();
+  columns_count_ = symbols_count + 1;
+  symbol_index_.fill(symbols_count);
+  for (uint32_t i = 0; i < symbols_count; ++i) {
+    symbol_index_[static_cast<unsigned char>(alphabet_[i])] = i;
+  }
+
+  const size_t vertexes_count = automaton.vertexes_count_;
+  if (vertexes_count >= std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Automaton is too large");
+  }
+
+  const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+  table_.assign((vertexes_count + 1) * columns_count_, kNone);
+  for (size_t v = 0; v < vertexes_count; ++v) {
+    for (const auto& edge : automaton.edges_[v]) {
+      uint32_t index = GetSymbolIndex(Automaton::GetSymbolOfEdge(edge));
+      const std::vector<size_t>& neighbors =
+          Automaton::GetNeighborsOfEdge(edge);
+      if (index == symbols_count || neighbors.size() != 1 ||
+          table_[v * columns_count_ + index] != kNone) {
+        throw std::runtime_error("Automaton is not complete deterministic");
+      }
+      table_[v * columns_count_ + index] = neighbors[0];
+    }
+  }
+
+  sink_ = vertexes_count;
+  for (size_t v = 0; v < vertexes_count; ++v) {
+    bool is_sink = automaton.terminal_vertexes_.count(v) == 0;
+    for (uint32_t c = 0; c < symbols_count; ++c) {
+      uint32_t to = table_[v * columns_count_ + c];
+      if (to == kNone) {
+        throw std::runtime_error("Automaton is not complete deterministic");
+      }
+      is_sink = is_sink && to == v;
+    }
+    if (is_sink && sink_ == vertexes_count) {
+      sink_ = v;
+    }
+  }
+
+  states_count_ = sink_ == vertexes_count ? vertexes_count + 1 : vertexes_count;
+  table_.resize(static_cast<size_t>(states_count_) * columns_count_);
+  for (size_t v = 0; v < states_count_; ++v) {
+    table_[v * columns_count_ + symbols_count] = sink_;
+  }
+  for (uint32_t c = 0; c < symbols_count; ++c) {
+    table_[static_cast<size_t>(sink_) * columns_count_ + c] = sink_;
+  }
+
+  terminal_.assign((states_count_ + 63) / 64, 0);
+  for (size_t v : automaton.terminal_vertexes_) {
+    terminal_[v >> 6] |= uint64_t{1} << (v & 63);
+  }
+
+  start_ = vertexes_count == 0 ? sink_ : automaton.start_;
+}
+
+uint32_t DenseDFA::Run(uint32_t state, std::string_view word) const {
+  const uint32_t* table = table_.data();
+  const uint32_t* symbol_index = symbol_index_.data();
+  const size_t columns_count = columns_count_;
+  for (char symbol : word) {
+    state = table[state * columns_count +
+                  symbol_index[static_cast<unsigned char>(symbol)]];
+  }
+  return state;
+}
+
+std::vector<bool> DenseDFA::Accepts(
+    std::span<const std::string_view> words) const {
+  std::vector<bool> result(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    result[i] = Accepts(words[i]);
+  }
+  return result;
+}
+
+void DenseDFA::Save(std::ostream& out) const {
+  DFAFileHeader header{};
+  std::memcpy(header.magic, DFAFileHeader::kMagic, sizeof(header.magic));
+  header.version = DFAFileHeader::kVersion;
+  header.states_count = states_count_;
+  header.columns_count = columns_count_;
+  header.start = start_;
+  header.sink = sink_;
+  header.alphabet_size = alphabet_.size();
+
+  DFAFileLayout layout = GetDFAFileLayout(header);
+  std::string data(layout.file_size, '\0');
+  std::memcpy(data.data() + layout.alphabet_offset, alphabet_.data(),
+              alphabet_.size());
+  std::memcpy(data.data() + layout.terminal_offset, terminal_.data(),
+              terminal_.size() * sizeof(uint64_t));
+  std::memcpy(data.data() + layout.table_offset, table_.data(),
+              table_.size() * sizeof(uint32_t));
+  header.checksum = GetDFAFileChecksum(data.data() + sizeof(header),
+                                       data.size() - sizeof(header));
+  std::memcpy(data.data(), &header, sizeof(header));
+  out.write(data.data(), data.size());
+}
+
+DenseDFA DenseDFA::Load(std::istream& in) {
+  std::string data(sizeof(DFAFileHeader), '\0');
+  if (!in.read(data.data(), data.size())) {
+    throw std::runtime_error("Incorrect DFA file");
+  }
+  DFAFileHeader header{};
+  std::memcpy(&header, data.data(), sizeof(header));
+  CheckDFAFileHeader(header);
+  DFAFileLayout layout = GetDFAFileLayout(header);
+  // The size comes from the header, so the payload is read in bounded pieces
+  // and a truncated or corrupt file fails before a huge allocation.
+  constexpr size_t kPieceSize = size_t{1} << 20;
+  while (data.size() < layout.file_size) {
+    const size_t offset = data.size();
+    data.resize(std::min(layout.file_size, offset + kPieceSize));
+    if (!in.read(data.data() + offset, data.size() - offset)) {
+      throw std::runtime_error("Incorrect DFA file");
+    }
+  }
+  CheckDFAFile(data.data(), data.size(), true);
+
+  DenseDFA dfa;
+  dfa.start_ = header.start;
+  dfa.sink_ = header.sink;
+  dfa.states_count_ = header.states_count;
+  dfa.columns_count_ = header.columns_count;
+  dfa.alphabet_.assign(data.data() + layout.alphabet_offset,
+                       header.alphabet_size);
+  dfa.symbol_index_.fill(header.alphabet_size);
+  for (uint32_t i = 0; i < header.alphabet_size; ++i) {
+    dfa.symbol_index_[static_cast<unsigned char>(dfa.alphabet_[i])] = i;
+  }
+  dfa.terminal_.resize((size_t{header.states_count} + 63) / 64);
+  std::memcpy(dfa.terminal_.data(), data.data() + layout.terminal_offset,
+              dfa.terminal_.size() * sizeof(uint64_t));
+  dfa.table_.resize(size_t{header.states_count} * header.columns_count);
+  std::memcpy(dfa.table_.data(), data.data() + layout.table_offset,
+              dfa.table_.size() * sizeof(uint32_t));
+  return dfa;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "automaton.hpp"
+
+// Complete deterministic automaton compiled into one flat transition table.
+// Letters of the alphabet are mapped to columns 0..k-1, every other byte is
+// mapped to column k, which leads to a rejecting sink state.
+class DenseDFA {
+ private:
+  uint32_t start_ = 0;
+  uint32_t sink_ = 0;
+  uint32_t states_count_ = 0;
+  uint32_t columns_count_ = 0;
+  std::string alphabet_;
+  std::array<uint32_t, 256> symbol_index_{};
+  std::vector<uint32_t> table_;  // states_count_ * columns_count_
+  std::vector<uint64_t> terminal_;
+
+ public:
+  DenseDFA() = default;
+
+  // The automaton has to be complete and deterministic, e.g. after ToCDFA()
+  // or ToMCDFA(). Otherwise std::runtime_error is thrown.
+  explicit DenseDFA(const Automaton& automaton);
+
+  uint32_t GetStart() const { return start_; }
+
+  // Rejecting state with all transitions leading to itself. Added to the
+  // states of the automaton if it has no such state.
+  uint32_t GetSink() const { return sink_; }
+
+  uint32_t GetStateCount() const { return states_count_; }
+
+  // Number of letters plus one column for bytes outside of the alphabet.
+  uint32_t GetColumnCount() const { return columns_count_; }
+
+  const std::string& GetAlphabet() const { return alphabet_; }
+
+  uint32_t GetSymbolIndex(char symbol) const {
+    return symbol_index_[static_cast<unsigned char>(symbol)];
+  }
+
+  uint32_t NextByIndex(uint32_t state, uint32_t index) const {
+    return table_[static_cast<size_t>(state) * columns_count_ + index];
+  }
+
+  uint32_t Next(uint32_t state, char symbol) const {
+    return NextByIndex(state, GetSymbolIndex(symbol));
+  }
+
+  bool IsTerminal(uint32_t state) const {
+    return (terminal_[state >> 6] >> (state & 63)) & 1;
+  }
+
+  const std::vector<uint32_t>& GetTable() const { return table_; }
+
+  // Columns of all bytes, indexed by the byte read as unsigned char.
+  const std::array<uint32_t, 256>& GetSymbolIndexes() const {
+    return symbol_index_;
+  }
+
+  // State reached from the given state after reading the word.
+  uint32_t Run(uint32_t state, std::string_view word) const;
+
+  uint32_t Run(std::string_view word) const { return Run(start_, word); }
+
+  bool Accepts(std::string_view word) const { return IsTerminal(Run(word)); }
+
+  std::vector<bool> Accepts(std::span<const std::string_view> words) const;
+
+  // Binary format described in dfa_file.hpp.
+  void Save(std::ostream& out) const;
+
+  // Throws std::runtime_error if the data is broken.
+  static DenseDFA Load(std::istream& in);
+};
@@ -0,0 +1,277 @@
+#include "derivative_dfa.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+size_t DerivativeDFA::TermHash::operator()(const Term& term) const {
+  size_t hash = static_cast<size_t>(term.kind) * 31 +
+                static_cast<unsigned char>(term.symbol);
+  for (uint32_t operand : term.operands) {
+    hash ^= operand + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+DerivativeDFA::DerivativeDFA(const std::string& regex) {
+  empty_ = MakeTerm({Kind::kEmpty, 0, {}}, false);
+  eps_ = MakeTerm({Kind::kEps, 0, {}}, true);
+
+  // Every operand on the stack is a list of factors, so that a chain of
+  // concatenations is built once at the end instead of being re-nested at
+  // every step. The empty list is eps.
+  std::vector<std::vector<uint32_t>> st;
+  std::vector<bool> is_letter(256, false);
+  for (char current_symbol : regex) {
+    if (current_symbol == '+' || current_symbol == '.') {
+      if (st.size() < 2) {
+        throw std::runtime_error("Incorrect regex");
+      }
+      std::vector<uint32_t> second = std::move(st.back());
+      st.pop_back();
+      std::vector<uint32_t>& first = st.back();
+      if (current_symbol == '+') {
+        first = {MakeUnion({MakeConcat(first), MakeConcat(second)})};
+      } else {
+        first.insert(first.end(), second.begin(), second.end());
+      }
+    } else if (current_symbol == '*') {
+      if (st.empty()) {
+        throw std::runtime_error("Incorrect regex");
+      }
+      st.back() = {MakeStar(MakeConcat(st.back()))};
+    } else if (current_symbol == '1') {
+      st.emplace_back();
+    } else {
+      is_letter[static_cast<unsigned char>(current_symbol)] = true;
+      st.push_back({MakeTerm({Kind::kLetter, current_symbol, {}}, false)});
+    }
+  }
+  if (st.size() != 1) {
+    throw std::runtime_error("Incorrect regex");
+  }
+
+  for (int c = std::numeric_limits<char>::min();
+       c <= std::numeric_limits<char>::max(); ++c) {
+    if (is_letter[static_cast<unsigned char>(c)]) {
+      alphabet_ += static_cast<char>(c);
+    }
+  }
+  columns_count_ = alphabet_.size() + 1;
+  symbol_index_.fill(alphabet_.size());
+  for (size_t i = 0; i < alphabet_.size(); ++i) {
+    symbol_index_[static_cast<unsigned char>(alphabet_[i])] = i;
+  }
+
+  start_ = AddState(MakeConcat(st.back()));
+}
+
+uint32_t DerivativeDFA::MakeTerm(Term term, bool is_nullable) {
+  auto [it, inserted] = term_ids_.emplace(term, terms_.size());
+  if (inserted) {
+    terms_.push_back(std::move(term));
+    is_nullable_.push_back(is_nullable);
+  }
+  return it->second;
+}
+
+uint32_t DerivativeDFA::MakeConcat(uint32_t first, uint32_t second) {
+  if (first == empty_ || second == empty_) {
+    return empty_;
+  }
+  if (first == eps_) {
+    return second;
+  }
+  if (second == eps_) {
+    return first;
+  }
+  return MakeTerm({Kind::kConcat, 0, {first, second}},
+                  is_nullable_[first] && is_nullable_[second]);
+}
+
+uint32_t DerivativeDFA::MakeConcat(const std::vector<uint32_t>& factors) {
+  // Chains of the regex are right-nested: (xy)z becomes x(yz). Derivatives
+  // are not re-nested, that would rebuild the whole chain at every step.
+  uint32_t result = eps_;
+  for (auto it = factors.rbegin(); it != factors.rend(); ++it) {
+    result = MakeConcat(*it, result);
+  }
+  return result;
+}
+
+uint32_t DerivativeDFA::MakeStar(uint32_t term) {
+  if (term == empty_ || term == eps_) {
+    return eps_;
+  }
+  if (terms_[term].kind == Kind::kStar) {
+    return term;
+  }
+  return MakeTerm({Kind::kStar, 0, {term}}, true);
+}
+
+uint32_t DerivativeDFA::MakeUnion(std::vector<uint32_t> operands) {
+  std::vector<uint32_t> flat;
+  for (uint32_t operand : operands) {
+    if (terms_[operand].kind == Kind::kUnion) {
+      flat.insert(flat.end(), terms_[operand].operands.begin(),
+                  terms_[operand].operands.end());
+    } else if (operand != empty_) {
+      flat.push_back(operand);
+    }
+  }
+  std::sort(flat.begin(), flat.end());
+  flat.erase(std::unique(flat.begin(), flat.end()), flat.end());
+
+  if (flat.empty()) {
+    return empty_;
+  }
+  if (flat.size() == 1) {
+    return flat[0];
+  }
+  bool is_nullable = false;
+  for (uint32_t operand : flat) {
+    is_nullable = is_nullable || is_nullable_[operand];
+  }
+  return MakeTerm({Kind::kUnion, 0, std::move(flat)}, is_nullable);
+}
+
+uint32_t DerivativeDFA::GetDerivative(uint32_t term, char symbol) {
+  const auto key = [symbol](uint32_t id) {
+    return (uint64_t{id} << 8) | static_cast<unsigned char>(symbol);
+  };
+  const auto derivative = [this, &key](uint32_t id) {
+    return derivatives_.at(key(id));
+  };
+
+  // A term is derived once the derivatives of the operands it needs are
+  // known. The explicit stack keeps deep regexes off the call stack.
+  std::vector<uint32_t> st = {term};
+  std::vector<uint32_t> needed;
+  while (!st.empty()) {
+    const uint32_t current = st.back();
+    if (derivatives_.contains(key(current))) {
+      st.pop_back();
+      continue;
+    }
+
+    // terms_ may grow below, so the operands are copied out first.
+    const Kind kind = terms_[current].kind;
+    const std::vector<uint32_t> operands = terms_[current].operands;
+    needed.clear();
+    if (kind == Kind::kUnion) {
+      needed = operands;
+    } else if (kind == Kind::kStar || kind == Kind::kConcat) {
+      needed.push_back(operands[0]);
+      if (kind == Kind::kConcat && is_nullable_[operands[0]]) {
+        needed.push_back(operands[1]);
+      }
+    }
+    bool is_ready = true;
+    for (uint32_t operand : needed) {
+      if (!derivatives_.contains(key(operand))) {
+        st.push_back(operand);
+        is_ready = false;
+      }
+    }
+    if (!is_ready) {
+      continue;
+    }
+    st.pop_back();
+
+    uint32_t result = empty_;
+    switch (kind) {
+      case Kind::kEmpty:
+      case Kind::kEps:
+        break;
+      case Kind::kLetter:
+        result = terms_[current].symbol == symbol ? eps_ : empty_;
+        break;
+      case Kind::kConcat: {
+        uint32_t head = MakeConcat(derivative(operands[0]), operands[1]);
+        result = is_nullable_[operands[0]]
+                     ? MakeUnion({head, derivative(operands[1])})
+                     : head;
+        break;
+      }
+      case Kind::kStar:
+        result = MakeConcat(derivative(operands[0]), current);
+        break;
+      case Kind::kUnion: {
+        std::vector<uint32_t> derivatives;
+        for (uint32_t operand : operands) {
+          derivatives.push_back(derivative(operand));
+        }
+        result = MakeUnion(std::move(derivatives));
+        break;
+      }
+    }
+    derivatives_.emplace(key(current), result);
+  }
+  return derivative(term);
+}
+
+uint32_t DerivativeDFA::AddState(uint32_t term) {
+  auto [it, inserted] = state_of_term_.emplace(term, state_terms_.size());
+  if (inserted) {
+    state_terms_.push_back(term);
+    transitions_.resize(transitions_.size() + columns_count_, kUnknown);
+  }
+  return it->second;
+}
+
+uint32_t DerivativeDFA::ComputeTransition(uint32_t state, uint32_t column) {
+  uint32_t term = column + 1 < columns_count_
+                      ? GetDerivative(state_terms_[state], alphabet_[column])
+                      : empty_;
+  uint32_t to = AddState(term);
+  transitions_[static_cast<size_t>(state) * columns_count_ + column] = to;
+  return to;
+}
+
+bool DerivativeDFA::Accepts(std::string_view word) {
+  uint32_t state = start_;
+  for (char symbol : word) {
+    uint32_t column = symbol_index_[static_cast<unsigned char>(symbol)];
+    uint32_t to = transitions_[static_cast<size_t>(state) * columns_count_ +
+                               column];
+    state = to == kUnknown ? ComputeTransition(state, column) : to;
+  }
+  return is_nullable_[state_terms_[state]];
+}
+
+Automaton DerivativeDFA::ToAutomaton() {
+  // States reached by other bytes only are left out, the rest is numbered in
+  // the order of the breadth-first search.
+  std::unordered_map<uint32_t, size_t> numbers = {{start_, 0}};
+  std::vector<uint32_t> order = {start_};
+  for (size_t i = 0; i < order.size(); ++i) {
+    for (uint32_t column = 0; column + 1 < columns_count_; ++column) {
+      uint32_t to = transitions_[static_cast<size_t>(order[i]) *
+                                     columns_count_ +
+                                 column];
+      if (to == kUnknown) {
+        to = ComputeTransition(order[i], column);
+      }
+      if (numbers.emplace(to, order.size()).second) {
+        order.push_back(to);
+      }
+    }
+  }
+
+  Automaton automaton;
+  automaton.start_ = 0;
+  automaton.alphabet_ = alphabet_;
+  automaton.vertexes_count_ = order.size();
+  automaton.edges_.resize(order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (is_nullable_[state_terms_[order[i]]]) {
+      automaton.terminal_vertexes_.insert(i);
+    }
+    for (uint32_t column = 0; column + 1 < columns_count_; ++column) {
+      uint32_t to =
+          transitions_[static_cast<size_t>(order[i]) * columns_count_ + column];
+      automaton.AddEdge(i, numbers[to], alphabet_[column]);
+    }
+  }
+  return automaton;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "automaton.hpp"
+
+// Deterministic automaton whose states are Brzozowski derivatives of the
+// regex. Terms are hash-consed and unions are kept flat, sorted and without
+// duplicates, so derivatives that differ only by associativity, commutativity
+// or idempotence of + are the same state. States and transitions are built
+// only when the input reaches them.
+class DerivativeDFA {
+ private:
+  static constexpr uint32_t kUnknown = UINT32_MAX;
+
+  enum class Kind : uint8_t { kEmpty, kEps, kLetter, kConcat, kStar, kUnion };
+
+  struct Term {
+    Kind kind;
+    char symbol;  // of a letter
+    // The two operands of a concatenation, the operand of a star or the
+    // sorted operands of a union.
+    std::vector<uint32_t> operands;
+
+    bool operator==(const Term& other) const = default;
+  };
+
+  struct TermHash {
+    size_t operator()(const Term& term) const;
+  };
+
+  std::vector<Term> terms_;
+  std::vector<bool> is_nullable_;
+  std::unordered_map<Term, uint32_t, TermHash> term_ids_;
+  std::unordered_map<uint64_t, uint32_t> derivatives_;
+  uint32_t empty_ = 0;
+  uint32_t eps_ = 0;
+
+  std::string alphabet_;
+  uint32_t columns_count_ = 0;
+  std::array<uint32_t, 256> symbol_index_{};
+  std::unordered_map<uint32_t, uint32_t> state_of_term_;
+  std::vector<uint32_t> state_terms_;
+  std::vector<uint32_t> transitions_;  // states * columns_count_
+  uint32_t start_ = 0;
+
+  uint32_t MakeTerm(Term term, bool is_nullable);
+
+  uint32_t MakeConcat(uint32_t first, uint32_t second);
+
+  // Concatenation of the factors from left to right, eps if there are none.
+  uint32_t MakeConcat(const std::vector<uint32_t>& factors);
+
+  uint32_t MakeStar(uint32_t term);
+
+  uint32_t MakeUnion(std::vector<uint32_t> operands);
+
+  uint32_t GetDerivative(uint32_t term, char symbol);
+
+  uint32_t AddState(uint32_t term);
+
+  uint32_t ComputeTransition(uint32_t state, uint32_t column);
+
+ public:
+  // Regex in reverse Polish notation.
+  explicit DerivativeDFA(const std::string& regex);
+
+  bool Accepts(std::string_view word);
+
+  size_t GetStateCount() const { return state_terms_.size(); }
+
+  size_t GetTermCount() const { return terms_.size(); }
+
+  // Builds all states reachable from the start and returns them as a complete
+  // deterministic automaton.
+  Automaton ToAutomaton();
+};
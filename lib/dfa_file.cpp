@@ -0,0 +1,108 @@
+#include "dfa_file.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+size_t AlignUp(size_t size) {
+  return (size + 7) & ~size_t{7};
+}
+
+}  // namespace
+
+DFAFileLayout GetDFAFileLayout(const DFAFileHeader& header) {
+  DFAFileLayout layout{};
+  layout.alphabet_offset = sizeof(DFAFileHeader);
+  layout.terminal_offset =
+      layout.alphabet_offset + AlignUp(header.alphabet_size);
+  layout.table_offset = layout.terminal_offset +
+                        (size_t{header.states_count} + 63) / 64 * 8;
+  layout.file_size =
+      layout.table_offset +
+      AlignUp(size_t{header.states_count} * header.columns_count * 4);
+  return layout;
+}
+
+uint64_t GetDFAFileChecksum(const char* data, size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+  for (size_t i = 0; i < size; i += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, data + i, std::min<size_t>(8, size - i));
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ULL;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+void CheckDFAFileHeader(const DFAFileHeader& header) {
+  if (std::memcmp(header.magic, DFAFileHeader::kMagic, sizeof(header.magic)) !=
+      0) {
+    throw std::runtime_error("Incorrect DFA file");
+  }
+  if (header.version != DFAFileHeader::kVersion) {
+    throw std::runtime_error("Unsupported DFA file version");
+  }
+  if (header.alphabet_size > 255 ||
+      header.columns_count != header.alphabet_size + 1 ||
+      header.start >= header.states_count ||
+      header.sink >= header.states_count) {
+    throw std::runtime_error("Incorrect DFA file");
+  }
+}
+
+DFAFileHeader CheckDFAFile(const char* data, size_t size, bool full_check) {
+  DFAFileHeader header{};
+  if (size < sizeof(header)) {
+    throw std::runtime_error("Incorrect DFA file");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  CheckDFAFileHeader(header);
+
+  DFAFileLayout layout = GetDFAFileLayout(header);
+  if (size != layout.file_size) {
+    throw std::runtime_error("Incorrect DFA file");
+  }
+  bool seen[256] = {};
+  for (size_t i = 0; i < header.alphabet_size; ++i) {
+    unsigned char symbol = data[layout.alphabet_offset + i];
+    if (seen[symbol]) {
+      throw std::runtime_error("Incorrect DFA file");
+    }
+    seen[symbol] = true;
+  }
+  if (full_check && GetDFAFileChecksum(data + sizeof(header),
+                                       size - sizeof(header)) !=
+                        header.checksum) {
+    throw std::runtime_error("DFA file checksum mismatch");
+  }
+
+  // The targets are always checked, as a broken one would be read outside of
+  // the table. The readers stop early at the sink, so it has to be a
+  // rejecting state with only self-loops.
+  const char* table = data + layout.table_offset;
+  const size_t transitions_count =
+      size_t{header.states_count} * header.columns_count;
+  for (size_t i = 0; i < transitions_count; ++i) {
+    uint32_t to = 0;
+    std::memcpy(&to, table + i * 4, 4);
+    if (to >= header.states_count) {
+      throw std::runtime_error("Incorrect DFA file");
+    }
+  }
+  const size_t sink_row = size_t{header.sink} * header.columns_count;
+  for (size_t i = sink_row; i < sink_row + header.columns_count; ++i) {
+    uint32_t to = 0;
+    std::memcpy(&to, table + i * 4, 4);
+    if (to != header.sink) {
+      throw std::runtime_error("Incorrect DFA file");
+    }
+  }
+  uint64_t terminal_word = 0;
+  std::memcpy(&terminal_word,
+              data + layout.terminal_offset + header.sink / 64 * 8, 8);
+  if ((terminal_word >> (header.sink % 64)) & 1) {
+    throw std::runtime_error("Incorrect DFA file");
+  }
+  return header;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// Binary file of a DenseDFA. The header is followed by the payload:
+//   alphabet          alphabet_size bytes
+//   terminal states   (states_count + 63) / 64 words of 64 bits
+//   transitions       states_count * columns_count numbers of 32 bits
+// Every section starts at a multiple of 8 bytes, the gaps are zero. Numbers
+// are stored in the byte order of the machine, which has to be little-endian,
+// so the file can be used in place after mmap.
+static_assert(std::endian::native == std::endian::little);
+
+struct DFAFileHeader {
+  static constexpr char kMagic[8] = {'A', 'U', 'T', 'O', 'M', 'D', 'F', 'A'};
+  static constexpr uint32_t kVersion = 1;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t states_count;
+  uint32_t columns_count;
+  uint32_t start;
+  uint32_t sink;
+  uint32_t alphabet_size;
+  uint64_t checksum;  // of the payload
+};
+
+static_assert(sizeof(DFAFileHeader) == 40);
+
+struct DFAFileLayout {
+  size_t alphabet_offset;
+  size_t terminal_offset;
+  size_t table_offset;
+  size_t file_size;
+};
+
+DFAFileLayout GetDFAFileLayout(const DFAFileHeader& header);
+
+uint64_t GetDFAFileChecksum(const char* data, size_t size);
+
+// Throws std::runtime_error if the header is broken.
+void CheckDFAFileHeader(const DFAFileHeader& header);
+
+// Checks the header, the size, the targets of the transitions and that the
+// sink is a rejecting state with only self-loops, so a file that passes is
+// safe to run. With full_check the checksum of the payload is verified too.
+// Throws std::runtime_error if the file is broken.
+DFAFileHeader CheckDFAFile(const char* data, size_t size, bool full_check);
@@ -0,0 +1,87 @@
+#include "lazy_dfa.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+LazyDFA::LazyDFA(const Automaton& automaton, size_t max_states)
+    : max_states_(max_states) {
+  if (max_states_ < 2) {
+    throw std::runtime_error("LazyDFA needs room for at least two states");
+  }
+
+  Automaton eps_free = automaton;
+  eps_free.RemoveEpsEdges();
+  nfa_ = CsrNFA(eps_free);
+
+  const std::string& alphabet = nfa_.GetAlphabet();
+  columns_count_ = alphabet.size() + 1;
+  symbol_index_.fill(alphabet.size());
+  for (size_t i = 0; i < alphabet.size(); ++i) {
+    symbol_index_[static_cast<unsigned char>(alphabet[i])] = i;
+  }
+
+  Flush();
+  flushes_count_ = 0;
+}
+
+uint32_t LazyDFA::AddState(SubsetTable::Subset subset) {
+  auto [id, inserted] = subsets_.Insert(std::move(subset));
+  if (inserted) {
+    bool is_terminal = false;
+    for (size_t v : subsets_.Get(id)) {
+      is_terminal = is_terminal || nfa_.IsTerminal(v);
+    }
+    is_terminal_.push_back(is_terminal);
+    transitions_.resize(transitions_.size() + columns_count_, kUnknown);
+  }
+  return id;
+}
+
+void LazyDFA::Flush() {
+  subsets_.Clear();
+  transitions_.clear();
+  is_terminal_.clear();
+  ++flushes_count_;
+
+  if (nfa_.GetVertexCount() == 0) {
+    start_ = AddState({});
+  } else {
+    start_ = AddState({nfa_.GetStart()});
+  }
+}
+
+uint32_t LazyDFA::ComputeTransition(uint32_t state, uint32_t column) {
+  SubsetTable::Subset targets;
+  if (column + 1 < columns_count_) {
+    for (size_t v : subsets_.Get(state)) {
+      for (size_t e = nfa_.EdgesBegin(v); e < nfa_.EdgesEnd(v); ++e) {
+        if (symbol_index_[static_cast<unsigned char>(nfa_.GetSymbol(e))] ==
+            column) {
+          targets.push_back(nfa_.GetTarget(e));
+        }
+      }
+    }
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+  }
+
+  if (subsets_.Size() >= max_states_ && !subsets_.Contains(targets)) {
+    Flush();
+    return AddState(std::move(targets));
+  }
+
+  uint32_t to = AddState(std::move(targets));
+  transitions_[static_cast<size_t>(state) * columns_count_ + column] = to;
+  return to;
+}
+
+bool LazyDFA::Accepts(std::string_view word) {
+  uint32_t state = start_;
+  for (char symbol : word) {
+    uint32_t column = symbol_index_[static_cast<unsigned char>(symbol)];
+    uint32_t to =
+        transitions_[static_cast<size_t>(state) * columns_count_ + column];
+    state = to != kUnknown ? to : ComputeTransition(state, column);
+  }
+  return is_terminal_[state];
+}
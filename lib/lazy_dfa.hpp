@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "automaton.hpp"
+#include "csr_nfa.hpp"
+#include "subset_table.hpp"
+
+// Deterministic automaton built on the fly from the eps-free automaton. Subsets
+// are determinized only when the input reaches them and are kept in a cache of
+// at most max_states states, which is cleared when it gets full.
+class LazyDFA {
+ private:
+  static constexpr uint32_t kUnknown = UINT32_MAX;
+
+  CsrNFA nfa_;
+  size_t max_states_;
+  uint32_t columns_count_;
+  std::array<uint32_t, 256> symbol_index_{};
+  SubsetTable subsets_;
+  std::vector<uint32_t> transitions_;  // states * columns_count_
+  std::vector<bool> is_terminal_;
+  uint32_t start_ = 0;
+  size_t flushes_count_ = 0;
+
+  uint32_t AddState(SubsetTable::Subset subset);
+
+  void Flush();
+
+  uint32_t ComputeTransition(uint32_t state, uint32_t column);
+
+ public:
+  static constexpr size_t kDefaultMaxStates = 4096;
+
+  explicit LazyDFA(const Automaton& automaton,
+                   size_t max_states = kDefaultMaxStates);
+
+  bool Accepts(std::string_view word);
+
+  size_t GetCachedStateCount() const { return subsets_.Size(); }
+
+  size_t GetFlushCount() const { return flushes_count_; }
+};
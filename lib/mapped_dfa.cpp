@@ -0,0 +1,45 @@
+#include "mapped_dfa.hpp"
+#include "dfa_file.hpp"
+
+MappedDFA::MappedDFA(const std::string& path, bool full_check)
+    : file_(path) {
+  DFAFileHeader header =
+      CheckDFAFile(file_.GetData(), file_.GetSize(), full_check);
+  DFAFileLayout layout = GetDFAFileLayout(header);
+
+  start_ = header.start;
+  sink_ = header.sink;
+  states_count_ = header.states_count;
+  columns_count_ = header.columns_count;
+  alphabet_ = std::string_view(file_.GetData() + layout.alphabet_offset,
+                               header.alphabet_size);
+  symbol_index_.fill(header.alphabet_size);
+  for (uint32_t i = 0; i < header.alphabet_size; ++i) {
+    symbol_index_[static_cast<unsigned char>(alphabet_[i])] = i;
+  }
+  // mmap returns page-aligned memory and the sections are aligned to 8 bytes.
+  terminal_ = reinterpret_cast<const uint64_t*>(file_.GetData() +
+                                                layout.terminal_offset);
+  table_ = reinterpret_cast<const uint32_t*>(file_.GetData() +
+                                             layout.table_offset);
+}
+
+uint32_t MappedDFA::Run(uint32_t state, std::string_view word) const {
+  const uint32_t* table = table_;
+  const uint32_t* symbol_index = symbol_index_.data();
+  const size_t columns_count = columns_count_;
+  for (char symbol : word) {
+    state = table[state * columns_count +
+                  symbol_index[static_cast<unsigned char>(symbol)]];
+  }
+  return state;
+}
+
+std::vector<bool> MappedDFA::Accepts(
+    std::span<const std::string_view> words) const {
+  std::vector<bool> result(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    result[i] = Accepts(words[i]);
+  }
+  return result;
+}
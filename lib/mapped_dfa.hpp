@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.hpp"
+
+// DenseDFA saved with DenseDFA::Save() and used directly from a read-only
+// memory mapping of the file. Only the 256-entry symbol index is built on
+// load, the transition table is never copied.
+class MappedDFA {
+ private:
+  MappedFile file_;
+  uint32_t start_ = 0;
+  uint32_t sink_ = 0;
+  uint32_t states_count_ = 0;
+  uint32_t columns_count_ = 0;
+  std::string_view alphabet_;
+  std::array<uint32_t, 256> symbol_index_{};
+  const uint32_t* table_ = nullptr;
+  const uint64_t* terminal_ = nullptr;
+
+ public:
+  // The targets of all transitions and the sink are always verified, so a
+  // corrupt file cannot make the runs read outside of the mapping. Without
+  // full_check only the checksum is skipped: a file whose table was altered
+  // into another valid automaton is then accepted, so it is for trusted files
+  // only. Throws std::runtime_error if the file is broken.
+  explicit MappedDFA(const std::string& path, bool full_check = true);
+
+  uint32_t GetStart() const { return start_; }
+
+  uint32_t GetSink() const { return sink_; }
+
+  uint32_t GetStateCount() const { return states_count_; }
+
+  uint32_t GetColumnCount() const { return columns_count_; }
+
+  std::string_view GetAlphabet() const { return alphabet_; }
+
+  uint32_t GetSymbolIndex(char symbol) const {
+    return symbol_index_[static_cast<unsigned char>(symbol)];
+  }
+
+  uint32_t NextByIndex(uint32_t state, uint32_t index) const {
+    return table_[static_cast<size_t>(state) * columns_count_ + index];
+  }
+
+  uint32_t Next(uint32_t state, char symbol) const {
+    return NextByIndex(state, GetSymbolIndex(symbol));
+  }
+
+  bool IsTerminal(uint32_t state) const {
+    return (terminal_[state >> 6] >> (state & 63)) & 1;
+  }
+
+  uint32_t Run(uint32_t state, std::string_view word) const;
+
+  uint32_t Run(std::string_view word) const { return Run(start_, word); }
+
+  bool Accepts(std::string_view word) const { return IsTerminal(Run(word)); }
+
+  std::vector<bool> Accepts(std::span<const std::string_view> words) const;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+
+ public:
+  MappedFile() = default;
+
+  // Throws std::runtime_error if the file cannot be opened or mapped.
+  explicit MappedFile(const std::string& path);
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept;
+
+  MappedFile& operator=(MappedFile&& other) noexcept;
+
+  ~MappedFile();
+
+  const char* GetData() const { return data_; }
+
+  size_t GetSize() const { return size_; }
+};
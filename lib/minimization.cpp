@@ -0,0 +1,488 @@
+#include "minimization.hpp"
+#include <algorithm>
+#include <barrier>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+std::vector<size_t> MooreClasses(const std::vector<size_t>& table,
+                                 size_t symbols_count,
+                                 const std::vector<size_t>& initial_classes,
+                                 size_t* rounds_count) {
+  const size_t vertexes_count = initial_classes.size();
+  std::vector<size_t> classes = initial_classes;
+  if (rounds_count != nullptr) {
+    *rounds_count = 0;
+  }
+  if (vertexes_count == 0) {
+    return classes;
+  }
+
+  const size_t width = symbols_count + 1;
+  std::vector<size_t> signatures(vertexes_count * width);
+  std::vector<size_t> order(vertexes_count);
+
+  auto signature_less = [&](size_t first, size_t second) {
+    return std::lexicographical_compare(
+        signatures.begin() + first * width,
+        signatures.begin() + (first + 1) * width,
+        signatures.begin() + second * width,
+        signatures.begin() + (second + 1) * width);
+  };
+  auto signature_equal = [&](size_t first, size_t second) {
+    return std::equal(signatures.begin() + first * width,
+                      signatures.begin() + (first + 1) * width,
+                      signatures.begin() + second * width);
+  };
+
+  std::vector<size_t> sorted = classes;
+  std::sort(sorted.begin(), sorted.end());
+  size_t number_of_classes =
+      std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+
+  for (size_t i = 0; i < vertexes_count; ++i) {
+    if (rounds_count != nullptr) {
+      ++*rounds_count;
+    }
+    for (size_t v = 0; v < vertexes_count; ++v) {
+      size_t* signature = &signatures[v * width];
+      signature[0] = classes[v];
+      for (size_t c = 0; c < symbols_count; ++c) {
+        signature[c + 1] = classes[table[v * symbols_count + c]];
+      }
+    }
+
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), signature_less);
+
+    classes[order[0]] = 0;
+    for (size_t j = 1; j < vertexes_count; ++j) {
+      classes[order[j]] = classes[order[j - 1]] +
+                          (signature_equal(order[j], order[j - 1]) ? 0 : 1);
+    }
+
+    size_t new_number_of_classes = classes[order[vertexes_count - 1]] + 1;
+    if (new_number_of_classes == number_of_classes) {
+      break;
+    }
+    number_of_classes = new_number_of_classes;
+  }
+  return classes;
+}
+
+std::vector<size_t> ParallelMooreClasses(
+    const std::vector<size_t>& table, size_t symbols_count,
+    const std::vector<size_t>& initial_classes, size_t threads_count,
+    size_t* rounds_count) {
+  const size_t vertexes_count = initial_classes.size();
+  threads_count = std::min(threads_count, vertexes_count);
+  if (threads_count <= 1) {
+    return MooreClasses(table, symbols_count, initial_classes, rounds_count);
+  }
+  if (rounds_count != nullptr) {
+    *rounds_count = 0;
+  }
+
+  std::vector<size_t> classes = initial_classes;
+  const size_t width = symbols_count + 1;
+  std::vector<size_t> signatures(vertexes_count * width);
+  std::vector<size_t> order(vertexes_count);
+  std::vector<size_t> buffer(vertexes_count);
+  std::vector<size_t> new_classes(vertexes_count);
+  std::vector<size_t> part_sums(threads_count);
+
+  auto signature_less = [&](size_t first, size_t second) {
+    return std::lexicographical_compare(
+        signatures.begin() + first * width,
+        signatures.begin() + (first + 1) * width,
+        signatures.begin() + second * width,
+        signatures.begin() + (second + 1) * width);
+  };
+  auto signature_equal = [&](size_t first, size_t second) {
+    return std::equal(signatures.begin() + first * width,
+                      signatures.begin() + (first + 1) * width,
+                      signatures.begin() + second * width);
+  };
+
+  std::vector<size_t> sorted = classes;
+  std::sort(sorted.begin(), sorted.end());
+  size_t number_of_classes =
+      std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+
+  // Every thread owns one part, which it sorts on its own before the parts
+  // are merged pairwise.
+  std::vector<size_t> bounds(threads_count + 1);
+  for (size_t i = 0; i <= threads_count; ++i) {
+    bounds[i] = vertexes_count * i / threads_count;
+  }
+
+  auto sort_part = [&](size_t begin, size_t end) {
+    for (size_t v = begin; v < end; ++v) {
+      size_t* signature = &signatures[v * width];
+      signature[0] = classes[v];
+      for (size_t c = 0; c < symbols_count; ++c) {
+        signature[c + 1] = classes[table[v * symbols_count + c]];
+      }
+      order[v] = v;
+    }
+    std::sort(order.begin() + begin, order.begin() + end, signature_less);
+  };
+  // The class of the j-th vertex in the order is the number of signature
+  // changes before it, counted in every part and then shifted by the changes
+  // in the previous parts.
+  auto count_changes = [&](size_t part, const size_t* merged) {
+    size_t changes = 0;
+    new_classes[bounds[part]] = 0;
+    for (size_t j = std::max<size_t>(bounds[part], 1); j < bounds[part + 1];
+         ++j) {
+      changes += signature_equal(merged[j], merged[j - 1]) ? 0 : 1;
+      new_classes[j] = changes;
+    }
+    part_sums[part] = changes;
+  };
+  auto assign_classes = [&](size_t part, const size_t* merged) {
+    size_t shift = part == 0 ? 0 : part_sums[part - 1];
+    for (size_t j = bounds[part]; j < bounds[part + 1]; ++j) {
+      classes[merged[j]] = new_classes[j] + shift;
+    }
+  };
+
+  // The threads live through all the rounds, the steps of a round are
+  // separated by the barrier and the serial ones are done by the part 0.
+  std::barrier sync(threads_count);
+  bool is_stable = false;
+  auto refine = [&](size_t part) {
+    for (size_t round = 0; round < vertexes_count; ++round) {
+      sort_part(bounds[part], bounds[part + 1]);
+      sync.arrive_and_wait();
+
+      // Merged parts go back and forth between order and buffer.
+      size_t* from = order.data();
+      size_t* to = buffer.data();
+      for (size_t step = 1; step < threads_count; step *= 2) {
+        if (part % (2 * step) == 0) {
+          size_t begin = bounds[part];
+          size_t middle = bounds[std::min(part + step, threads_count)];
+          size_t end = bounds[std::min(part + 2 * step, threads_count)];
+          std::merge(from + begin, from + middle, from + middle, from + end,
+                     to + begin, signature_less);
+        }
+        std::swap(from, to);
+        sync.arrive_and_wait();
+      }
+
+      count_changes(part, from);
+      sync.arrive_and_wait();
+      if (part == 0) {
+        if (rounds_count != nullptr) {
+          ++*rounds_count;
+        }
+        std::partial_sum(part_sums.begin(), part_sums.end(),
+                         part_sums.begin());
+        size_t new_number_of_classes = part_sums.back() + 1;
+        is_stable = new_number_of_classes == number_of_classes;
+        number_of_classes = new_number_of_classes;
+      }
+      sync.arrive_and_wait();
+
+      assign_classes(part, from);
+      if (is_stable) {
+        return;
+      }
+      sync.arrive_and_wait();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t part = 1; part < threads_count; ++part) {
+    threads.emplace_back(refine, part);
+  }
+  refine(0);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  return classes;
+}
+
+std::vector<size_t> HopcroftClasses(
+    const std::vector<size_t>& table, size_t symbols_count,
+    const std::vector<size_t>& initial_classes, size_t* rounds_count) {
+  const size_t vertexes_count = initial_classes.size();
+  if (rounds_count != nullptr) {
+    *rounds_count = 0;
+  }
+  if (vertexes_count == 0) {
+    return {};
+  }
+  constexpr size_t kNone = static_cast<size_t>(-1);
+
+  // Predecessors of every vertex by every letter in one flat array.
+  std::vector<size_t> inverse_begin(symbols_count * (vertexes_count + 1) + 1,
+                                    0);
+  std::vector<size_t> inverse(vertexes_count * symbols_count);
+  for (size_t v = 0; v < vertexes_count; ++v) {
+    for (size_t c = 0; c < symbols_count; ++c) {
+      ++inverse_begin[c * (vertexes_count + 1) +
+                      table[v * symbols_count + c] + 1];
+    }
+  }
+  std::partial_sum(inverse_begin.begin(), inverse_begin.end(),
+                   inverse_begin.begin());
+  {
+    std::vector<size_t> position(inverse_begin.begin(),
+                                 inverse_begin.end() - 1);
+    for (size_t v = 0; v < vertexes_count; ++v) {
+      for (size_t c = 0; c < symbols_count; ++c) {
+        size_t to = table[v * symbols_count + c];
+        inverse[position[c * (vertexes_count + 1) + to]++] = v;
+      }
+    }
+  }
+
+  // Vertexes of every block occupy [begin, end) in elements.
+  std::vector<size_t> elements(vertexes_count);
+  std::iota(elements.begin(), elements.end(), 0);
+  std::stable_sort(elements.begin(), elements.end(),
+                   [&initial_classes](size_t first, size_t second) {
+                     return initial_classes[first] < initial_classes[second];
+                   });
+
+  std::vector<size_t> block_of(vertexes_count);
+  std::vector<size_t> location(vertexes_count);
+  std::vector<size_t> begin;
+  std::vector<size_t> end;
+  for (size_t i = 0; i < vertexes_count; ++i) {
+    size_t v = elements[i];
+    if (i == 0 ||
+        initial_classes[v] != initial_classes[elements[i - 1]]) {
+      begin.push_back(i);
+      end.push_back(i);
+    }
+    block_of[v] = begin.size() - 1;
+    location[v] = i;
+    ++end.back();
+  }
+
+  // The blocks are kept in a list in the order Moore would number them, and
+  // every block remembers its position among the parts of the split it came
+  // from. Blocks of the same split are the only ones ever compared.
+  std::vector<size_t> prev(vertexes_count, kNone);
+  std::vector<size_t> next(vertexes_count, kNone);
+  std::vector<size_t> rank_in_split(vertexes_count, 0);
+  size_t head = 0;
+  for (size_t b = 0; b < begin.size(); ++b) {
+    rank_in_split[b] = b;
+    prev[b] = b == 0 ? kNone : b - 1;
+    next[b] = b + 1 == begin.size() ? kNone : b + 1;
+  }
+
+  // The refinement goes round by round like Moore's does. In round i the
+  // splitters are the parts created in round i - 1 except the largest part
+  // of every split, so every vertex is a member of O(log n) splitters. Two
+  // vertexes of a block stay together iff the splitters hit them by the same
+  // letters, because their targets can only differ by parts of one split.
+  std::vector<size_t> splitters;
+  {
+    size_t largest = 0;
+    for (size_t b = 1; b < begin.size(); ++b) {
+      if (end[b] - begin[b] > end[largest] - begin[largest]) {
+        largest = b;
+      }
+    }
+    for (size_t b = 0; b < begin.size(); ++b) {
+      if (b != largest) {
+        splitters.push_back(b);
+      }
+    }
+  }
+
+  struct Touch {
+    size_t vertex;
+    size_t symbol;
+    size_t splitter;
+  };
+  struct Signature {
+    size_t vertex;
+    size_t from;
+    size_t to;
+  };
+  struct Split {
+    size_t block;
+    size_t first_group;
+    size_t groups_count;
+  };
+  std::vector<Touch> touches;
+  std::vector<Signature> signatures;
+  std::vector<std::pair<size_t, size_t>> groups;  // ranges in elements
+  std::vector<Split> splits;
+
+  auto touch_less = [&touches](const Signature& first,
+                               const Signature& second) {
+    return std::lexicographical_compare(
+        touches.begin() + first.from, touches.begin() + first.to,
+        touches.begin() + second.from, touches.begin() + second.to,
+        [](const Touch& lhs, const Touch& rhs) {
+          return std::tie(lhs.symbol, lhs.splitter) <
+                 std::tie(rhs.symbol, rhs.splitter);
+        });
+  };
+  auto touch_equal = [&touches](const Signature& first,
+                                const Signature& second) {
+    return std::equal(touches.begin() + first.from, touches.begin() + first.to,
+                      touches.begin() + second.from,
+                      touches.begin() + second.to,
+                      [](const Touch& lhs, const Touch& rhs) {
+                        return lhs.symbol == rhs.symbol &&
+                               lhs.splitter == rhs.splitter;
+                      });
+  };
+  // Moore's order of two vertexes that are equivalent in the previous round.
+  auto moore_less = [&](size_t first, size_t second) {
+    for (size_t c = 0; c < symbols_count; ++c) {
+      size_t first_block = block_of[table[first * symbols_count + c]];
+      size_t second_block = block_of[table[second * symbols_count + c]];
+      if (first_block != second_block) {
+        return rank_in_split[first_block] < rank_in_split[second_block];
+      }
+    }
+    return false;
+  };
+
+  while (!splitters.empty()) {
+    if (rounds_count != nullptr) {
+      ++*rounds_count;
+    }
+    touches.clear();
+    for (size_t splitter : splitters) {
+      for (size_t c = 0; c < symbols_count; ++c) {
+        for (size_t i = begin[splitter]; i < end[splitter]; ++i) {
+          size_t to = elements[i];
+          size_t from_begin = inverse_begin[c * (vertexes_count + 1) + to];
+          size_t from_end = inverse_begin[c * (vertexes_count + 1) + to + 1];
+          for (size_t j = from_begin; j < from_end; ++j) {
+            touches.push_back({inverse[j], c, splitter});
+          }
+        }
+      }
+    }
+    splitters.clear();
+    std::stable_sort(touches.begin(), touches.end(),
+                     [](const Touch& first, const Touch& second) {
+                       return first.vertex < second.vertex;
+                     });
+
+    signatures.clear();
+    for (size_t i = 0; i < touches.size(); ++i) {
+      if (i == 0 || touches[i].vertex != touches[i - 1].vertex) {
+        signatures.push_back({touches[i].vertex, i, i});
+      }
+      ++signatures.back().to;
+    }
+    std::sort(signatures.begin(), signatures.end(),
+              [&](const Signature& first, const Signature& second) {
+                if (block_of[first.vertex] != block_of[second.vertex]) {
+                  return block_of[first.vertex] < block_of[second.vertex];
+                }
+                return touch_less(first, second);
+              });
+
+    // Find the parts of every block and sort them in Moore's order while the
+    // blocks of the previous round are still intact.
+    groups.clear();
+    splits.clear();
+    for (size_t i = 0; i < signatures.size();) {
+      size_t block = block_of[signatures[i].vertex];
+      size_t first_group = groups.size();
+      size_t position = begin[block];
+      for (; i < signatures.size() &&
+             block_of[signatures[i].vertex] == block;
+           ++i) {
+        if (position == begin[block] ||
+            !touch_equal(signatures[i], signatures[i - 1])) {
+          groups.emplace_back(position, position);
+        }
+        size_t v = signatures[i].vertex;
+        size_t u = elements[position];
+        std::swap(elements[location[v]], elements[position]);
+        location[u] = location[v];
+        location[v] = position;
+        ++groups.back().second;
+        ++position;
+      }
+      if (position != end[block]) {
+        groups.emplace_back(position, end[block]);
+      }
+      if (groups.size() - first_group == 1) {
+        groups.pop_back();
+        continue;
+      }
+      std::sort(groups.begin() + first_group, groups.end(),
+                [&](const auto& first, const auto& second) {
+                  return moore_less(elements[first.first],
+                                    elements[second.first]);
+                });
+      splits.push_back({block, first_group, groups.size() - first_group});
+    }
+
+    for (const Split& split : splits) {
+      size_t largest = split.first_group;
+      for (size_t g = split.first_group;
+           g < split.first_group + split.groups_count; ++g) {
+        if (groups[g].second - groups[g].first >
+            groups[largest].second - groups[largest].first) {
+          largest = g;
+        }
+      }
+
+      size_t last = split.block;
+      for (size_t g = split.first_group;
+           g < split.first_group + split.groups_count; ++g) {
+        size_t block = split.block;
+        if (g != largest) {
+          block = begin.size();
+          begin.push_back(groups[g].first);
+          end.push_back(groups[g].second);
+          for (size_t i = groups[g].first; i < groups[g].second; ++i) {
+            block_of[elements[i]] = block;
+          }
+          splitters.push_back(block);
+
+          // Parts before the largest one go in front of the old block, the
+          // others after the previously linked part.
+          size_t anchor = g < largest ? split.block : last;
+          size_t before = g < largest ? prev[anchor] : anchor;
+          size_t after = g < largest ? anchor : next[anchor];
+          prev[block] = before;
+          next[block] = after;
+          if (before == kNone) {
+            head = block;
+          } else {
+            next[before] = block;
+          }
+          if (after != kNone) {
+            prev[after] = block;
+          }
+        } else {
+          begin[block] = groups[g].first;
+          end[block] = groups[g].second;
+        }
+        if (g >= largest) {
+          last = block;
+        }
+        rank_in_split[block] = g - split.first_group;
+      }
+    }
+  }
+
+  std::vector<size_t> numbers(begin.size());
+  size_t number = 0;
+  for (size_t b = head; b != kNone; b = next[b]) {
+    numbers[b] = number++;
+  }
+  for (size_t& block : block_of) {
+    block = numbers[block];
+  }
+  return block_of;
+}
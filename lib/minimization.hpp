@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Both functions take a complete DFA as a flat transition table, where
+// table[v * symbols_count + i] is the target of vertex v by the i-th letter,
+// and the initial classes of the vertexes. They return the class of every
+// vertex in the coarsest refinement that is stable under the transitions.
+// If rounds_count is given, the number of refinement rounds is stored there.
+
+// Moore refinement. Classes are numbered in the order of their signatures
+// (previous class, classes of the targets), exactly as ToMCDFA numbers them.
+// O(n^2 log n) in the worst case.
+std::vector<size_t> MooreClasses(const std::vector<size_t>& table,
+                                 size_t symbols_count,
+                                 const std::vector<size_t>& initial_classes,
+                                 size_t* rounds_count = nullptr);
+
+// MooreClasses with the signatures, the sorting and the numbering of every
+// round split between threads. Gives exactly the same classes.
+std::vector<size_t> ParallelMooreClasses(
+    const std::vector<size_t>& table, size_t symbols_count,
+    const std::vector<size_t>& initial_classes, size_t threads_count,
+    size_t* rounds_count = nullptr);
+
+// Hopcroft partition refinement, O(n * symbols_count * log n). Splitters are
+// processed round by round, so the classes get the same numbers as
+// MooreClasses gives them.
+std::vector<size_t> HopcroftClasses(const std::vector<size_t>& table,
+                                    size_t symbols_count,
+                                    const std::vector<size_t>& initial_classes,
+                                    size_t* rounds_count = nullptr);
@@ -0,0 +1,145 @@
+#include "multi_pattern_dfa.hpp"
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include "csr_nfa.hpp"
+#include "minimization.hpp"
+#include "subset_table.hpp"
+
+namespace {
+
+std::vector<Automaton> ParsePatterns(const std::vector<std::string>& regexes) {
+  std::vector<Automaton> patterns;
+  patterns.reserve(regexes.size());
+  for (const std::string& regex : regexes) {
+    patterns.emplace_back(regex);
+  }
+  return patterns;
+}
+
+}  // namespace
+
+MultiPatternDFA::MultiPatternDFA(const std::vector<Automaton>& patterns)
+    : patterns_count_(patterns.size()) {
+  // The union of the patterns without eps edges, vertexes of the i-th
+  // pattern are shifted by shifts[i].
+  std::vector<CsrNFA> nfas;
+  std::vector<size_t> shifts;
+  std::vector<uint32_t> pattern_of_vertex;
+  for (const Automaton& pattern : patterns) {
+    Automaton eps_free = pattern;
+    eps_free.RemoveEpsEdges();
+    nfas.emplace_back(eps_free);
+    shifts.push_back(pattern_of_vertex.size());
+    pattern_of_vertex.resize(pattern_of_vertex.size() +
+                                 nfas.back().GetVertexCount(),
+                             nfas.size() - 1);
+    alphabet_ += nfas.back().GetAlphabet();
+  }
+  std::sort(alphabet_.begin(), alphabet_.end());
+  alphabet_.erase(std::unique(alphabet_.begin(), alphabet_.end()),
+                  alphabet_.end());
+
+  const size_t symbols_count = alphabet_.size();
+  columns_count_ = symbols_count + 1;
+  symbol_index_.fill(symbols_count);
+  for (size_t i = 0; i < symbols_count; ++i) {
+    symbol_index_[static_cast<unsigned char>(alphabet_[i])] = i;
+  }
+
+  SubsetTable::Subset start;
+  for (size_t i = 0; i < nfas.size(); ++i) {
+    if (nfas[i].GetVertexCount() != 0) {
+      start.push_back(shifts[i] + nfas[i].GetStart());
+    }
+  }
+
+  // Subsets are explored in the order of their ids, the transitions form the
+  // table of a complete DFA with the empty subset as the dead state.
+  SubsetTable subsets;
+  subsets.Insert(std::move(start));
+  std::vector<size_t> table;
+  std::vector<std::vector<uint32_t>> accepted;
+  std::vector<SubsetTable::Subset> delta(symbols_count);
+  for (size_t id = 0; id < subsets.Size(); ++id) {
+    for (SubsetTable::Subset& targets : delta) {
+      targets.clear();
+    }
+    std::vector<uint32_t> ids;
+    for (size_t v : subsets.Get(id)) {
+      const uint32_t pattern = pattern_of_vertex[v];
+      const CsrNFA& nfa = nfas[pattern];
+      const size_t local = v - shifts[pattern];
+      if (nfa.IsTerminal(local)) {
+        ids.push_back(pattern);
+      }
+      for (size_t e = nfa.EdgesBegin(local); e < nfa.EdgesEnd(local); ++e) {
+        delta[symbol_index_[static_cast<unsigned char>(nfa.GetSymbol(e))]]
+            .push_back(shifts[pattern] + nfa.GetTarget(e));
+      }
+    }
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    accepted.push_back(std::move(ids));
+
+    for (SubsetTable::Subset& targets : delta) {
+      std::sort(targets.begin(), targets.end());
+      targets.erase(std::unique(targets.begin(), targets.end()),
+                    targets.end());
+      table.push_back(subsets.Insert(targets).first);
+    }
+  }
+  auto [dead, inserted] = subsets.Insert({});
+  if (inserted) {
+    table.resize(table.size() + symbols_count, dead);
+    accepted.emplace_back();
+  }
+  if (subsets.Size() >= std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Automaton is too large");
+  }
+
+  // States with different sets of ids start in different classes.
+  std::map<std::vector<uint32_t>, size_t> class_of_ids;
+  std::vector<size_t> initial_classes;
+  for (const std::vector<uint32_t>& ids : accepted) {
+    initial_classes.push_back(
+        class_of_ids.emplace(ids, class_of_ids.size()).first->second);
+  }
+  const std::vector<size_t> classes =
+      HopcroftClasses(table, symbols_count, initial_classes);
+
+  states_count_ = *std::max_element(classes.begin(), classes.end()) + 1;
+  start_ = classes[0];
+  sink_ = classes[dead];
+  table_.assign(static_cast<size_t>(states_count_) * columns_count_, sink_);
+  std::vector<const std::vector<uint32_t>*> accepted_of_state(states_count_);
+  for (size_t v = 0; v < subsets.Size(); ++v) {
+    const size_t row = classes[v] * columns_count_;
+    for (size_t i = 0; i < symbols_count; ++i) {
+      table_[row + i] = classes[table[v * symbols_count + i]];
+    }
+    accepted_of_state[classes[v]] = &accepted[v];
+  }
+
+  accepted_offsets_.push_back(0);
+  for (const std::vector<uint32_t>* ids : accepted_of_state) {
+    accepted_.insert(accepted_.end(), ids->begin(), ids->end());
+    accepted_offsets_.push_back(accepted_.size());
+  }
+}
+
+MultiPatternDFA::MultiPatternDFA(const std::vector<std::string>& regexes)
+    : MultiPatternDFA(ParsePatterns(regexes)) {}
+
+uint32_t MultiPatternDFA::Run(std::string_view word) const {
+  uint32_t state = start_;
+  for (char symbol : word) {
+    state = Next(state, symbol);
+  }
+  return state;
+}
+
+std::vector<uint32_t> MultiPatternDFA::Match(std::string_view word) const {
+  std::span<const uint32_t> ids = GetAcceptedPatterns(Run(word));
+  return {ids.begin(), ids.end()};
+}
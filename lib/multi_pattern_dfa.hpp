@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "automaton.hpp"
+
+// One complete DFA for many patterns. Every state knows the ids of the
+// patterns that accept the words leading to it, so one walk over a word
+// tells all patterns that match it. The DFA is built by the subset
+// construction on the union of the patterns and minimized with the initial
+// partition by the sets of accepted ids, so states with different sets are
+// never merged. Bytes outside of the alphabet lead to the sink.
+class MultiPatternDFA {
+ private:
+  uint32_t start_ = 0;
+  uint32_t sink_ = 0;
+  uint32_t states_count_ = 0;
+  uint32_t columns_count_ = 0;
+  size_t patterns_count_ = 0;
+  std::string alphabet_;
+  std::array<uint32_t, 256> symbol_index_{};
+  std::vector<uint32_t> table_;  // states_count_ * columns_count_
+  // Ids accepted in the state v, in increasing order, are stored in
+  // accepted_ from accepted_offsets_[v] to accepted_offsets_[v + 1].
+  std::vector<uint32_t> accepted_offsets_;
+  std::vector<uint32_t> accepted_;
+
+ public:
+  // The id of a pattern is its index.
+  explicit MultiPatternDFA(const std::vector<Automaton>& patterns);
+
+  // Regexes in reverse Polish notation.
+  explicit MultiPatternDFA(const std::vector<std::string>& regexes);
+
+  size_t GetPatternCount() const { return patterns_count_; }
+
+  uint32_t GetStart() const { return start_; }
+
+  uint32_t GetSink() const { return sink_; }
+
+  uint32_t GetStateCount() const { return states_count_; }
+
+  const std::string& GetAlphabet() const { return alphabet_; }
+
+  uint32_t Next(uint32_t state, char symbol) const {
+    return table_[static_cast<size_t>(state) * columns_count_ +
+                  symbol_index_[static_cast<unsigned char>(symbol)]];
+  }
+
+  // State reached from the start after reading the word.
+  uint32_t Run(std::string_view word) const;
+
+  // Ids of the patterns accepting in the state, in increasing order.
+  std::span<const uint32_t> GetAcceptedPatterns(uint32_t state) const {
+    return {accepted_.data() + accepted_offsets_[state],
+            accepted_.data() + accepted_offsets_[state + 1]};
+  }
+
+  // Ids of the patterns matching the whole word, in increasing order.
+  std::vector<uint32_t> Match(std::string_view word) const;
+};
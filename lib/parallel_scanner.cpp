@@ -0,0 +1,161 @@
+#include "parallel_scanner.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include "mapped_file.hpp"
+
+ParallelScanner::ParallelScanner(std::shared_ptr<const DenseDFA> dfa,
+                                 size_t threads_count)
+    : dfa_(std::move(dfa)),
+      threads_count_(std::max<size_t>(threads_count, 1)) {}
+
+ParallelScanner::ParallelScanner(const Automaton& automaton,
+                                 size_t threads_count)
+    : ParallelScanner(std::make_shared<const DenseDFA>(automaton),
+                      threads_count) {}
+
+uint32_t ParallelScanner::RunFrom(uint32_t state,
+                                  std::string_view input) const {
+  // The sink is checked once per block to keep the inner loop branch-free.
+  for (size_t i = 0; i < input.size() && state != dfa_->GetSink();
+       i += kBlockSize) {
+    state = dfa_->Run(state, input.substr(i, kBlockSize));
+  }
+  return state;
+}
+
+ParallelScanner::ChunkMap ParallelScanner::RunFromAllStates(
+    std::string_view chunk) const {
+  const uint32_t states_count = dfa_->GetStateCount();
+  const uint32_t kNone = std::numeric_limits<uint32_t>::max();
+  ChunkMap map;
+  // Every walk costs a transition per byte, so one byte from all states may
+  // already cost the whole budget.
+  const size_t probe_budget = chunk.size() / kProbeShare;
+  if (states_count > probe_budget) {
+    return map;
+  }
+  size_t probe_work = states_count;
+
+  // A walk is named by the state it started from. A merged walk points to
+  // the one it was merged into, the state map is resolved at the end.
+  std::vector<uint32_t> parent(states_count);
+  std::vector<uint32_t> origins(states_count);
+  map.walks.resize(states_count);
+  for (uint32_t state = 0; state < states_count; ++state) {
+    parent[state] = state;
+    origins[state] = state;
+    map.walks[state] = state;
+  }
+
+  std::vector<uint32_t> walk_of_target(states_count, kNone);
+  std::vector<uint32_t> merged;
+  std::vector<uint32_t> merged_origins;
+  size_t position = 0;
+  while (map.walks.size() > 1 && position < chunk.size()) {
+    // While there are many walks they are merged after every byte.
+    const bool is_probing = map.walks.size() > kMaxWalksCount;
+    if (is_probing) {
+      probe_work += map.walks.size();
+      if (probe_work > probe_budget) {
+        return map;
+      }
+    }
+    const std::string_view block =
+        chunk.substr(position, is_probing ? 1 : kBlockSize);
+    position += block.size();
+    // The walks are independent, so stepping them together overlaps their
+    // loads.
+    for (char symbol : block) {
+      const uint32_t index = dfa_->GetSymbolIndex(symbol);
+      for (uint32_t& walk : map.walks) {
+        walk = dfa_->NextByIndex(walk, index);
+      }
+    }
+
+    merged.clear();
+    merged_origins.clear();
+    for (size_t i = 0; i < map.walks.size(); ++i) {
+      uint32_t& walk = walk_of_target[map.walks[i]];
+      if (walk == kNone) {
+        walk = merged.size();
+        merged.push_back(map.walks[i]);
+        merged_origins.push_back(origins[i]);
+      } else {
+        parent[origins[i]] = merged_origins[walk];
+      }
+    }
+    for (uint32_t target : merged) {
+      walk_of_target[target] = kNone;
+    }
+    map.walks.swap(merged);
+    origins.swap(merged_origins);
+  }
+
+  if (map.walks.size() == 1) {
+    map.walks[0] = RunFrom(map.walks[0], chunk.substr(position));
+  }
+  // walk_of_target is reused as the walk of every remaining origin.
+  for (size_t i = 0; i < origins.size(); ++i) {
+    walk_of_target[origins[i]] = i;
+  }
+  map.walk_of_state.resize(states_count);
+  for (uint32_t state = 0; state < states_count; ++state) {
+    uint32_t origin = state;
+    while (parent[origin] != origin) {
+      origin = parent[origin];
+    }
+    for (uint32_t node = state; node != origin;) {
+      const uint32_t next = parent[node];
+      parent[node] = origin;
+      node = next;
+    }
+    map.walk_of_state[state] = walk_of_target[origin];
+  }
+  map.is_complete = true;
+  return map;
+}
+
+uint32_t ParallelScanner::Run(std::string_view input) const {
+  const size_t chunks_count =
+      std::min(threads_count_, input.size() / kMinChunkSize);
+  if (chunks_count <= 1) {
+    return RunFrom(dfa_->GetStart(), input);
+  }
+
+  std::vector<std::string_view> chunks;
+  for (size_t i = 0; i < chunks_count; ++i) {
+    const size_t begin = input.size() * i / chunks_count;
+    const size_t end = input.size() * (i + 1) / chunks_count;
+    chunks.push_back(input.substr(begin, end - begin));
+  }
+
+  std::vector<ChunkMap> maps(chunks_count);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < chunks_count; ++i) {
+    threads.emplace_back(
+        [this, &maps, &chunks, i] { maps[i] = RunFromAllStates(chunks[i]); });
+  }
+  uint32_t state = RunFrom(dfa_->GetStart(), chunks[0]);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (size_t i = 1; i < chunks_count; ++i) {
+    if (maps[i].is_complete) {
+      state = maps[i].walks[maps[i].walk_of_state[state]];
+    } else {
+      state = RunFrom(state, chunks[i]);
+    }
+  }
+  return state;
+}
+
+bool ParallelScanner::Accepts(std::string_view input) const {
+  return dfa_->IsTerminal(Run(input));
+}
+
+bool ParallelScanner::AcceptsFile(const std::string& path) const {
+  MappedFile file(path);
+  return Accepts(std::string_view(file.GetData(), file.GetSize()));
+}
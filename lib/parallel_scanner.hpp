@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "automaton.hpp"
+#include "dense_dfa.hpp"
+
+// Matches one large input on several threads. The input is split into
+// chunks, one per thread. The first chunk is run from the start state, every
+// other one from all states of the automaton at once: walks that reach the
+// same state are merged, so for most automata a single walk is left after a
+// few bytes. The state maps of the chunks are then composed in order.
+//
+// Speculation on a chunk is given up once it has cost a quarter of the
+// transitions of a serial scan of the chunk while more than kMaxWalksCount
+// walks are left, and is not tried at all for automata with more states than
+// that. Such a chunk is run again from its real start state during the
+// serial composition, so it costs at most 1.25 serial scans of it, and the
+// whole input at worst about that much more than a serial scan. A chunk with
+// a few walks left steps them together up to its end.
+class ParallelScanner {
+ private:
+  // Inputs with less bytes per thread are split into less chunks.
+  static constexpr size_t kMinChunkSize = size_t{1} << 16;
+  // A chunk is given up if it still has more walks after its probe budget of
+  // chunk.size() / kProbeShare transitions is spent.
+  static constexpr size_t kMaxWalksCount = 4;
+  static constexpr size_t kProbeShare = 4;
+  static constexpr size_t kBlockSize = 64;
+
+  // Final states of the walks of a chunk from all states of the automaton.
+  struct ChunkMap {
+    bool is_complete = false;
+    std::vector<uint32_t> walk_of_state;
+    std::vector<uint32_t> walks;
+  };
+
+  std::shared_ptr<const DenseDFA> dfa_;
+  size_t threads_count_;
+
+ public:
+  explicit ParallelScanner(
+      std::shared_ptr<const DenseDFA> dfa,
+      size_t threads_count = std::thread::hardware_concurrency());
+
+  // The automaton has to be complete deterministic, e.g. after ToMCDFA().
+  explicit ParallelScanner(
+      const Automaton& automaton,
+      size_t threads_count = std::thread::hardware_concurrency());
+
+  size_t GetThreadCount() const { return threads_count_; }
+
+  // State reached from the start after reading the input.
+  uint32_t Run(std::string_view input) const;
+
+  bool Accepts(std::string_view input) const;
+
+  // The file is mapped into memory and read in place.
+  bool AcceptsFile(const std::string& path) const;
+
+ private:
+  // Stops early once the sink is reached.
+  uint32_t RunFrom(uint32_t state, std::string_view input) const;
+
+  ChunkMap RunFromAllStates(std::string_view chunk) const;
+};
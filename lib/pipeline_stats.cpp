@@ -0,0 +1,26 @@
+#include "pipeline_stats.hpp"
+#include <sstream>
+
+void PipelineStats::Clear() {
+  stages.clear();
+  subsets_count = 0;
+  subsets_bytes = 0;
+  refinement_rounds = 0;
+}
+
+std::string PipelineStats::ToJson() const {
+  std::ostringstream out;
+  out << "{\"stages\": [";
+  for (size_t i = 0; i < stages.size(); ++i) {
+    const StageStats& stage = stages[i];
+    out << (i == 0 ? "" : ", ") << "{\"name\": \"" << stage.name
+        << "\", \"vertexes\": " << stage.vertexes_count
+        << ", \"edges\": " << stage.edges_count
+        << ", \"bytes\": " << stage.bytes
+        << ", \"seconds\": " << stage.seconds << '}';
+  }
+  out << "], \"subsets\": " << subsets_count
+      << ", \"subsets_bytes\": " << subsets_bytes
+      << ", \"refinement_rounds\": " << refinement_rounds << '}';
+  return out.str();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Measurements of one call of a stage. Nested stages are recorded separately
+// and before the stage that called them, and their time is included in it.
+struct StageStats {
+  std::string name;
+  size_t vertexes_count = 0;  // after the stage
+  size_t edges_count = 0;     // after the stage
+  size_t bytes = 0;           // approximate memory held by the automaton
+  double seconds = 0;         // wall time
+};
+
+// Sink for the statistics of the construction pipeline. Filled only if it is
+// passed to the automaton, otherwise nothing is measured at all.
+struct PipelineStats {
+  std::vector<StageStats> stages;
+  size_t subsets_count = 0;      // subsets explored by ToDFA
+  size_t subsets_bytes = 0;      // memory of the explored subsets
+  size_t refinement_rounds = 0;  // rounds of the refinement in ToMCDFA
+
+  void Clear();
+
+  std::string ToJson() const;
+};
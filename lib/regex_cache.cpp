@@ -0,0 +1,66 @@
+#include "regex_cache.hpp"
+#include <functional>
+
+RegexCache::RegexCache(size_t capacity)
+    : shard_capacity_((capacity + kShardsCount - 1) / kShardsCount),
+      shards_(kShardsCount) {
+  if (shard_capacity_ == 0) {
+    shard_capacity_ = 1;
+  }
+}
+
+RegexCache& RegexCache::Global() {
+  static RegexCache cache;
+  return cache;
+}
+
+RegexCache::Shard& RegexCache::GetShard(const std::string& regex) {
+  return shards_[std::hash<std::string>()(regex) % kShardsCount];
+}
+
+std::shared_ptr<const CompiledAutomaton> RegexCache::Get(
+    const std::string& regex) {
+  Shard& shard = GetShard(regex);
+  {
+    std::lock_guard lock(shard.mutex);
+    if (auto it = shard.positions.find(regex); it != shard.positions.end()) {
+      shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+      ++hits_count_;
+      return it->second->second;
+    }
+  }
+  ++misses_count_;
+
+  auto compiled = std::make_shared<const CompiledAutomaton>(regex);
+
+  std::lock_guard lock(shard.mutex);
+  if (auto it = shard.positions.find(regex); it != shard.positions.end()) {
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    return it->second->second;
+  }
+  shard.entries.emplace_front(regex, compiled);
+  shard.positions.emplace(regex, shard.entries.begin());
+  if (shard.entries.size() > shard_capacity_) {
+    shard.positions.erase(shard.entries.back().first);
+    shard.entries.pop_back();
+    ++evictions_count_;
+  }
+  return compiled;
+}
+
+size_t RegexCache::GetSize() {
+  size_t size = 0;
+  for (Shard& shard : shards_) {
+    std::lock_guard lock(shard.mutex);
+    size += shard.entries.size();
+  }
+  return size;
+}
+
+void RegexCache::Clear() {
+  for (Shard& shard : shards_) {
+    std::lock_guard lock(shard.mutex);
+    shard.positions.clear();
+    shard.entries.clear();
+  }
+}
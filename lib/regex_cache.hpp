@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "compiled_automaton.hpp"
+
+// Thread-safe LRU cache of compiled regexes keyed by the RPN string. The keys
+// are spread over independent shards, each with its own lock, so threads
+// working with different patterns rarely wait for each other.
+class RegexCache {
+ public:
+  static constexpr size_t kDefaultCapacity = 1024;
+  static constexpr size_t kShardsCount = 16;
+
+ private:
+  struct Shard {
+    using Entry =
+        std::pair<std::string, std::shared_ptr<const CompiledAutomaton>>;
+
+    std::mutex mutex;
+    std::list<Entry> entries;  // the most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> positions;
+  };
+
+  size_t shard_capacity_;
+  std::vector<Shard> shards_;
+  std::atomic<size_t> hits_count_ = 0;
+  std::atomic<size_t> misses_count_ = 0;
+  std::atomic<size_t> evictions_count_ = 0;
+
+  Shard& GetShard(const std::string& regex);
+
+ public:
+  // The capacity is split evenly between the shards.
+  explicit RegexCache(size_t capacity = kDefaultCapacity);
+
+  RegexCache(const RegexCache&) = delete;
+
+  RegexCache& operator=(const RegexCache&) = delete;
+
+  // Cache used by the static entry points of Automaton.
+  static RegexCache& Global();
+
+  // Compiles the regex on a miss. The lock is not held while compiling, so
+  // two threads missing on the same regex may both compile it; only one
+  // result is kept. Incorrect regexes throw and are not cached.
+  std::shared_ptr<const CompiledAutomaton> Get(const std::string& regex);
+
+  size_t GetSize();
+
+  void Clear();
+
+  size_t GetHitCount() const { return hits_count_; }
+
+  size_t GetMissCount() const { return misses_count_; }
+
+  size_t GetEvictionCount() const { return evictions_count_; }
+};
@@ -0,0 +1,143 @@
+#include "searcher.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+Automaton Reverse(Automaton automaton) {
+  automaton.Reverse();
+  return automaton;
+}
+
+Automaton MinimizeReversed(Automaton automaton) {
+  automaton.Reverse();
+  automaton.ToMCDFA();
+  return automaton;
+}
+
+}  // namespace
+
+Searcher::ScanTable::ScanTable(Automaton automaton) {
+  automaton.AddAnyPrefix();
+  automaton.ToMCDFA();
+  const DenseDFA dfa(automaton);
+
+  // Premultiplied targets must fit into 32 bits.
+  if (dfa.GetTable().size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Automaton is too large for Searcher");
+  }
+  columns_count = dfa.GetColumnCount();
+  start = dfa.GetStart() * columns_count;
+  symbol_index = dfa.GetSymbolIndexes();
+  table = dfa.GetTable();
+  is_terminal.resize(table.size());
+  for (uint32_t state = 0; state < dfa.GetStateCount(); ++state) {
+    const size_t row = static_cast<size_t>(state) * columns_count;
+    // Any match may start right after a byte outside of the alphabet.
+    table[row + columns_count - 1] = dfa.GetStart();
+    for (size_t i = row; i < row + columns_count; ++i) {
+      table[i] *= columns_count;
+    }
+    is_terminal[row] = dfa.IsTerminal(state);
+  }
+}
+
+Searcher::Searcher(const Automaton& automaton)
+    : forward_(automaton),
+      backward_(Reverse(automaton)),
+      reversed_(MinimizeReversed(automaton)) {}
+
+Searcher::Searcher(const std::string& regex) : Searcher(Automaton(regex)) {}
+
+std::vector<size_t> Searcher::FindEnds(std::string_view text) const {
+  std::vector<size_t> ends;
+  uint32_t state = forward_.start;
+  if (forward_.is_terminal[state]) {
+    ends.push_back(0);
+  }
+  for (size_t i = 0; i < text.size(); ++i) {
+    state = forward_.table[state + forward_.symbol_index[static_cast<
+                                       unsigned char>(text[i])]];
+    if (forward_.is_terminal[state]) {
+      ends.push_back(i + 1);
+    }
+  }
+  return ends;
+}
+
+std::vector<bool> Searcher::FindStarts(std::string_view text) const {
+  std::vector<bool> starts(text.size() + 1);
+  uint32_t state = backward_.start;
+  starts[text.size()] = backward_.is_terminal[state];
+  for (size_t i = text.size(); i > 0; --i) {
+    state = backward_.table[state + backward_.symbol_index[static_cast<
+                                        unsigned char>(text[i - 1])]];
+    starts[i - 1] = backward_.is_terminal[state];
+  }
+  return starts;
+}
+
+std::vector<size_t> Searcher::FindLongestEnds(std::string_view text) const {
+  // A match [begin, end) is read backwards by the DFA of L^R from the offset
+  // end. The walks from all offsets that are in the same state at the same
+  // offset go on together, and of them only the largest end matters, so
+  // every state keeps just that.
+  const uint32_t sink = reversed_.GetSink();
+  std::vector<size_t> longest_ends(text.size() + 1, kNoMatch);
+  std::vector<size_t> end_of_state(reversed_.GetStateCount(), kNoMatch);
+  std::vector<size_t> next_end_of_state(reversed_.GetStateCount(), kNoMatch);
+  std::vector<uint32_t> states;
+  std::vector<uint32_t> next_states;
+  for (size_t i = text.size();; --i) {
+    const uint32_t start = reversed_.GetStart();
+    if (start != sink && end_of_state[start] == kNoMatch) {
+      states.push_back(start);
+      end_of_state[start] = i;
+    }
+    for (uint32_t state : states) {
+      if (reversed_.IsTerminal(state) &&
+          (longest_ends[i] == kNoMatch ||
+           end_of_state[state] > longest_ends[i])) {
+        longest_ends[i] = end_of_state[state];
+      }
+    }
+    if (i == 0) {
+      break;
+    }
+
+    for (uint32_t state : states) {
+      const uint32_t to = reversed_.Next(state, text[i - 1]);
+      if (to != sink) {
+        if (next_end_of_state[to] == kNoMatch) {
+          next_states.push_back(to);
+          next_end_of_state[to] = end_of_state[state];
+        } else {
+          next_end_of_state[to] =
+              std::max(next_end_of_state[to], end_of_state[state]);
+        }
+      }
+      end_of_state[state] = kNoMatch;
+    }
+    states.swap(next_states);
+    next_states.clear();
+    end_of_state.swap(next_end_of_state);
+  }
+  return longest_ends;
+}
+
+std::vector<Searcher::Match> Searcher::FindAll(std::string_view text) const {
+  const std::vector<size_t> longest_ends = FindLongestEnds(text);
+  std::vector<Match> matches;
+  for (size_t begin = 0; begin <= text.size();) {
+    if (longest_ends[begin] == kNoMatch) {
+      ++begin;
+      continue;
+    }
+    const size_t end = longest_ends[begin];
+    matches.push_back({begin, end});
+    begin = end > begin ? end : begin + 1;
+  }
+  return matches;
+}
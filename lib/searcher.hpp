@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "automaton.hpp"
+#include "dense_dfa.hpp"
+
+// Finds the words of the language inside of a text. Bytes outside of the
+// alphabet of the automaton may occur in the text, they only break matches.
+// Every pass reads the text once, without backtracking:
+// - the ends of all matches are found with the DFA of A*L, where A is the
+//   alphabet;
+// - the starts of all matches are found with the DFA of A*L^R run backwards
+//   from the end of the text;
+// - the ends of the longest matches from all starts are found with the DFA
+//   of L^R run backwards from every offset at once, keeping the largest end
+//   per state, so the pass takes O(n * number of states of the DFA).
+class Searcher {
+ public:
+  // Half-open range [begin, end) of the text.
+  struct Match {
+    size_t begin;
+    size_t end;
+
+    bool operator==(const Match&) const = default;
+  };
+
+  static constexpr size_t kNoMatch = static_cast<size_t>(-1);
+
+ private:
+  // DFA of A*L: a byte outside of the alphabet leads to the start instead of
+  // the sink. Targets are premultiplied by the number of columns, so a
+  // table of more than 2^32 - 1 cells throws std::runtime_error.
+  struct ScanTable {
+    uint32_t start = 0;
+    uint32_t columns_count = 0;
+    std::array<uint32_t, 256> symbol_index{};
+    std::vector<uint32_t> table;
+    std::vector<bool> is_terminal;  // indexed by premultiplied states
+
+    explicit ScanTable(Automaton automaton);
+  };
+
+  ScanTable forward_;
+  ScanTable backward_;
+  DenseDFA reversed_;
+
+ public:
+  explicit Searcher(const Automaton& automaton);
+
+  // Regex in reverse Polish notation.
+  explicit Searcher(const std::string& regex);
+
+  // Increasing offsets at which a match ends, one forward pass.
+  std::vector<size_t> FindEnds(std::string_view text) const;
+
+  // Whether some match starts at every offset from 0 to text.size(), one
+  // backward pass.
+  std::vector<bool> FindStarts(std::string_view text) const;
+
+  // End of the longest match starting at every offset from 0 to
+  // text.size(), kNoMatch if none starts there. One backward pass.
+  std::vector<size_t> FindLongestEnds(std::string_view text) const;
+
+  // Non-overlapping matches, leftmost-longest: the match with the leftmost
+  // start is taken and extended as far as possible, the search continues
+  // from its end. After an empty match the next byte is skipped. Linear in
+  // the text, as it only reads FindLongestEnds.
+  std::vector<Match> FindAll(std::string_view text) const;
+};
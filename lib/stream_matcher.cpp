@@ -0,0 +1,29 @@
+#include "stream_matcher.hpp"
+#include <algorithm>
+#include <utility>
+
+StreamMatcher::StreamMatcher(std::shared_ptr<const DenseDFA> dfa)
+    : dfa_(std::move(dfa)), state_(dfa_->GetStart()) {}
+
+StreamMatcher::StreamMatcher(const Automaton& automaton)
+    : StreamMatcher(std::make_shared<const DenseDFA>(automaton)) {}
+
+void StreamMatcher::Feed(const char* data, size_t size) {
+  // The sink is checked once per block to keep the inner loop branch-free.
+  for (size_t i = 0; i < size && !IsDead(); i += kBlockSize) {
+    size_t block_size = std::min(kBlockSize, size - i);
+    state_ = dfa_->Run(state_, std::string_view(data + i, block_size));
+  }
+}
+
+bool StreamMatcher::Finish() const {
+  return dfa_->IsTerminal(state_);
+}
+
+bool StreamMatcher::IsDead() const {
+  return state_ == dfa_->GetSink();
+}
+
+void StreamMatcher::Reset() {
+  state_ = dfa_->GetStart();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "automaton.hpp"
+#include "dense_dfa.hpp"
+
+// Matches a word that arrives in chunks. Only the current state is kept
+// between the chunks; once the sink of the automaton is reached the rest of
+// the input is skipped.
+class StreamMatcher {
+ private:
+  static constexpr size_t kBlockSize = 64;
+
+  std::shared_ptr<const DenseDFA> dfa_;
+  uint32_t state_;
+
+ public:
+  explicit StreamMatcher(std::shared_ptr<const DenseDFA> dfa);
+
+  // The automaton has to be complete deterministic, e.g. after ToMCDFA().
+  explicit StreamMatcher(const Automaton& automaton);
+
+  void Feed(const char* data, size_t size);
+
+  void Feed(std::string_view chunk) { Feed(chunk.data(), chunk.size()); }
+
+  // Whether the word fed since the last Reset() is accepted.
+  bool Finish() const;
+
+  bool IsDead() const;
+
+  void Reset();
+};
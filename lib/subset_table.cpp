@@ -0,0 +1,61 @@
+#include "subset_table.hpp"
+#include <algorithm>
+#include <numeric>
+
+size_t SubsetTable::SubsetHash::operator()(const Subset& subset) const {
+  size_t hash = subset.size();
+  for (size_t v : subset) {
+    hash ^= v + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
+std::pair<size_t, bool> SubsetTable::Insert(Subset subset) {
+  auto [it, inserted] = ids_.emplace(std::move(subset), subsets_.size());
+  if (inserted) {
+    subsets_.push_back(&it->first);
+  }
+  return {it->second, inserted};
+}
+
+bool SubsetTable::Contains(const Subset& subset) const {
+  return ids_.count(subset) != 0;
+}
+
+const SubsetTable::Subset& SubsetTable::Get(size_t id) const {
+  return *subsets_[id];
+}
+
+size_t SubsetTable::Size() const {
+  return subsets_.size();
+}
+
+void SubsetTable::Clear() {
+  ids_.clear();
+  subsets_.clear();
+}
+
+bool SubsetTable::MaskLess(const Subset& first, const Subset& second) {
+  return std::lexicographical_compare(first.rbegin(), first.rend(),
+                                      second.rbegin(), second.rend());
+}
+
+std::vector<size_t> SubsetTable::GetMaskOrderRanks() const {
+  return GetMaskOrderRanks(subsets_);
+}
+
+std::vector<size_t> SubsetTable::GetMaskOrderRanks(
+    const std::vector<const Subset*>& subsets) {
+  std::vector<size_t> order(subsets.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&subsets](size_t first, size_t second) {
+              return MaskLess(*subsets[first], *subsets[second]);
+            });
+
+  std::vector<size_t> ranks(subsets.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    ranks[order[i]] = i;
+  }
+  return ranks;
+}
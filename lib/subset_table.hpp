@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Hash-consed storage of NFA state subsets. Every distinct subset gets a dense
+// id in the order it was first inserted.
+class SubsetTable {
+ public:
+  using Subset = std::vector<size_t>;  // sorted, without duplicates
+
+  struct SubsetHash {
+    size_t operator()(const Subset& subset) const;
+  };
+
+ private:
+  std::unordered_map<Subset, size_t, SubsetHash> ids_;
+  std::vector<const Subset*> subsets_;
+
+ public:
+  SubsetTable() = default;
+
+  SubsetTable(const SubsetTable&) = delete;
+
+  SubsetTable& operator=(const SubsetTable&) = delete;
+
+  // Moving keeps the nodes of the hash table, so the pointers stay valid.
+  SubsetTable(SubsetTable&&) = default;
+
+  SubsetTable& operator=(SubsetTable&&) = default;
+
+  // Returns the id of the subset and whether it was seen for the first time.
+  std::pair<size_t, bool> Insert(Subset subset);
+
+  bool Contains(const Subset& subset) const;
+
+  const Subset& Get(size_t id) const;
+
+  size_t Size() const;
+
+  // Subsets indexed by their ids.
+  const std::vector<const Subset*>& GetSubsets() const { return subsets_; }
+
+  void Clear();
+
+  // Ranks of all subsets in the order of their bitmask values, i.e. the
+  // numbering the subsets would get if they were stored as integer masks.
+  std::vector<size_t> GetMaskOrderRanks() const;
+
+  static std::vector<size_t> GetMaskOrderRanks(
+      const std::vector<const Subset*>& subsets);
+
+  static bool MaskLess(const Subset& first, const Subset& second);
+};
@@ -0,0 +1,78 @@
+#include "suffix_query.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+DenseDFA Minimize(Automaton automaton) {
+  automaton.ToMCDFA();
+  return DenseDFA(automaton);
+}
+
+}  // namespace
+
+SuffixQuery::SuffixQuery(const DenseDFA& dfa) {
+  const uint32_t states_count = dfa.GetStateCount();
+  std::vector<uint32_t> in_degree(states_count);
+  std::vector<size_t> longest_path(states_count);
+  std::vector<uint32_t> queue(states_count);
+
+  for (char symbol : dfa.GetAlphabet()) {
+    const uint32_t index = dfa.GetSymbolIndex(symbol);
+    std::fill(in_degree.begin(), in_degree.end(), 0);
+    std::fill(longest_path.begin(), longest_path.end(), 0);
+    for (uint32_t v = 0; v < states_count; ++v) {
+      ++in_degree[dfa.NextByIndex(v, index)];
+    }
+
+    // Peeling the states without predecessors leaves exactly the cycles.
+    size_t queue_end = 0;
+    for (uint32_t v = 0; v < states_count; ++v) {
+      if (in_degree[v] == 0) {
+        queue[queue_end++] = v;
+      }
+    }
+    for (size_t i = 0; i < queue_end; ++i) {
+      uint32_t v = queue[i];
+      uint32_t to = dfa.NextByIndex(v, index);
+      longest_path[to] = std::max(longest_path[to], longest_path[v] + 1);
+      if (--in_degree[to] == 0) {
+        queue[queue_end++] = to;
+      }
+    }
+
+    size_t lengths_count = 0;
+    for (uint32_t v = 0; v < states_count; ++v) {
+      if (!dfa.IsTerminal(v)) {
+        continue;
+      }
+      if (in_degree[v] != 0) {
+        lengths_count = kUnbounded;
+        break;
+      }
+      lengths_count = std::max(lengths_count, longest_path[v] + 1);
+    }
+    lengths_count_[static_cast<unsigned char>(symbol)] = lengths_count;
+  }
+}
+
+SuffixQuery::SuffixQuery(Automaton automaton)
+    : SuffixQuery(Minimize(std::move(automaton))) {}
+
+SuffixQuery::SuffixQuery(const std::string& regex)
+    : SuffixQuery(Automaton(regex)) {}
+
+bool SuffixQuery::IsSuffixByLetterFixLength(char symbol, size_t length) const {
+  size_t lengths_count = lengths_count_[static_cast<unsigned char>(symbol)];
+  return lengths_count == kUnbounded || length < lengths_count;
+}
+
+std::vector<bool> SuffixQuery::IsSuffixByLetterFixLength(
+    char symbol, std::span<const size_t> lengths) const {
+  size_t lengths_count = lengths_count_[static_cast<unsigned char>(symbol)];
+  std::vector<bool> result(lengths.size());
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    result[i] = lengths_count == kUnbounded || lengths[i] < lengths_count;
+  }
+  return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+#include "automaton.hpp"
+#include "dense_dfa.hpp"
+
+// Answers IsSuffixByLetterFixLength for any letter and length in O(1) after
+// one pass over the automaton.
+//
+// For a letter x the states form a functional graph v -> delta(v, x). A state
+// t is reachable by a walk of exactly k steps iff t lies on a cycle or k does
+// not exceed the longest path ending in t, so every letter is described by
+// the number of lengths k for which some terminal state is reachable.
+class SuffixQuery {
+ private:
+  static constexpr size_t kUnbounded = static_cast<size_t>(-1);
+
+  // Number of lengths answered positively, kUnbounded if all are.
+  std::array<size_t, 256> lengths_count_{};
+
+ public:
+  // Every state of the automaton has to be reachable from the start, e.g.
+  // after ToMCDFA().
+  explicit SuffixQuery(const DenseDFA& dfa);
+
+  // Minimizes a copy of the automaton.
+  explicit SuffixQuery(Automaton automaton);
+
+  // Regex in reverse Polish notation.
+  explicit SuffixQuery(const std::string& regex);
+
+  // Whether symbol^length is a suffix of some word of the language.
+  bool IsSuffixByLetterFixLength(char symbol, size_t length) const;
+
+  std::vector<bool> IsSuffixByLetterFixLength(
+      char symbol, std::span<const size_t> lengths) const;
+};
@@ -1,7 +1,32 @@
+#include <chrono>
 #include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
+#include "adaptive_matcher.hpp"
 #include "automaton.hpp"
+#include "automaton_parser.hpp"
+#include "batch_runner.hpp"
+#include "bit_parallel_nfa.hpp"
+#include "compiled_automaton.hpp"
+#include "csr_nfa.hpp"
+#include "dense_dfa.hpp"
+#include "derivative_dfa.hpp"
+#include "dfa_file.hpp"
+#include "stream_matcher.hpp"
+#include "lazy_dfa.hpp"
+#include "mapped_dfa.hpp"
+#include "multi_pattern_dfa.hpp"
+#include "parallel_scanner.hpp"
+#include "pipeline_stats.hpp"
+#include "regex_cache.hpp"
+#include "searcher.hpp"
+#include "suffix_query.hpp"
 #include "gtest/gtest.h"
 
 TEST(Regex_to_NKA, Throw) {
@@ -267,3 +292,869 @@ TEST(IsSuffixByLetterFixLength, Сorrectness) {
   EXPECT_TRUE(Automaton::IsSuffixByLetterFixLength(str, 'a', 10));
   EXPECT_FALSE(Automaton::IsSuffixByLetterFixLength(str, 'b', 1));
 }
+
+TEST(Regex_to_DKA, MoreThan32States) {
+  std::string str = "a";  // a^40
+  for (size_t i = 1; i < 40; ++i) {
+    str += "a.";
+  }
+  Automaton nka(str);
+  nka.RemoveEpsEdges();
+  EXPECT_EQ(nka.GetVertexCount(), 41);
+
+  Automaton automaton(str);
+  automaton.ToCDFA();
+  EXPECT_EQ(automaton.GetVertexCount(), 42);
+
+  str = "ab+*a.";  // (a + b)*a(a + b)^6
+  for (size_t i = 0; i < 6; ++i) {
+    str += "ab+.";
+  }
+  automaton = Automaton(str);
+  automaton.ToMCDFA();
+  EXPECT_EQ(automaton.GetVertexCount(), 128);
+}
+
+TEST(Regex_to_MPDKA, HopcroftEqualsMoore) {
+  std::vector<std::string> regexes = {
+      "x",           "a*",         "ab+c*.",     "ab+*c.ac+*.",
+      "ab.ba.+*c.ca+*.", "ab+*aa.ab+*.b.b.ab.a.+.b*.a.b*.",
+      "ab+*a.ab+.ab+.ab+.ab+."};
+  for (const std::string& str : regexes) {
+    Automaton hopcroft(str);
+    hopcroft.ToMCDFA(MinimizationAlgorithm::kHopcroft);
+
+    Automaton moore(str);
+    moore.ToMCDFA(MinimizationAlgorithm::kMoore);
+
+    EXPECT_TRUE(hopcroft == moore) << str;
+  }
+}
+
+TEST(Regex_to_DKA, AddEdge) {
+  std::istringstream in("0\n\n1\n\n0 1 a\n");
+  Automaton automaton;
+  in >> automaton;
+  automaton.AddEdge(0, 1, 'b');
+  automaton.AddEdge(1, 0, '1');
+  EXPECT_EQ(automaton.GetAlphabet(), "ab");
+
+  automaton.ToMCDFA();
+  DenseDFA dfa(automaton);
+  EXPECT_TRUE(dfa.Accepts("b"));
+  EXPECT_TRUE(dfa.Accepts("ab"));
+  EXPECT_FALSE(dfa.Accepts("c"));
+}
+
+TEST(Regex_to_MPDKA, Twice) {
+  std::vector<std::string> regexes = {"1", "a", "ab+*c.ac+*."};
+  for (const std::string& str : regexes) {
+    Automaton once(str);
+    once.ToMCDFA();
+
+    Automaton twice(str);
+    twice.ToMCDFA();
+    twice.ToMCDFA();
+
+    EXPECT_EQ(once.GetVertexCount(), twice.GetVertexCount()) << str;
+  }
+}
+
+TEST(NKA_to_NKA_without_eps, MoreThan1000Vertexes) {
+  std::string str = "a";  // a^600
+  for (size_t i = 1; i < 600; ++i) {
+    str += "a.";
+  }
+  Automaton automaton(str);
+  EXPECT_EQ(automaton.GetVertexCount(), 1200);
+
+  automaton.RemoveEpsEdges();
+  EXPECT_EQ(automaton.GetVertexCount(), 601);
+}
+
+TEST(NKA_to_NKA_without_eps, RemovesDeadVertexes) {
+  // 2 and 3 are reachable from the start, but no terminal is reachable from
+  // them
+  std::istringstream in("0\n\n1\n\n0 1 a\n0 2 b\n2 3 a\n3 2 b\n");
+  Automaton automaton;
+  in >> automaton;
+  automaton.RemoveEpsEdges();
+
+  std::ostringstream out;
+  out << automaton;
+  EXPECT_EQ(automaton.GetVertexCount(), 2);
+  EXPECT_EQ(out.str(), "0\n\n1\n\n0 1 a\n");
+}
+
+TEST(MPDKA_to_DenseDFA, Сorrectness) {
+  std::ifstream in("../tests/txt/MPDKA/input1.txt",
+                   std::ifstream::in);  // (a + b)*c(a + c)*
+  Automaton automaton;
+  in >> automaton;
+  DenseDFA dfa(automaton);
+
+  EXPECT_EQ(dfa.GetAlphabet(), "abc");
+  EXPECT_EQ(dfa.GetColumnCount(), 4);
+  EXPECT_EQ(dfa.GetStateCount(), automaton.GetVertexCount());
+
+  uint32_t state = dfa.GetStart();
+  EXPECT_FALSE(dfa.IsTerminal(state));
+  state = dfa.Next(state, 'c');
+  EXPECT_TRUE(dfa.IsTerminal(state));
+  state = dfa.Next(state, 'a');
+  EXPECT_TRUE(dfa.IsTerminal(state));
+  state = dfa.Next(state, 'b');
+  EXPECT_EQ(state, dfa.GetSink());
+  EXPECT_EQ(dfa.Next(dfa.GetStart(), 'x'), dfa.GetSink());
+}
+
+TEST(MPDKA_to_DenseDFA, Throw) {
+  Automaton automaton(std::string("ab+*c."));
+  automaton.ToDFA();
+  EXPECT_THROW(DenseDFA dfa(automaton), std::runtime_error);
+
+  automaton.ToCDFA();
+  EXPECT_NO_THROW(DenseDFA dfa(automaton));
+
+  automaton = Automaton(std::string("a*"));  // no sink in the automaton
+  automaton.ToMCDFA();
+  DenseDFA dfa(automaton);
+  EXPECT_EQ(dfa.GetStateCount(), automaton.GetVertexCount() + 1);
+  EXPECT_EQ(dfa.Next(dfa.GetStart(), 'a'), dfa.GetStart());
+  EXPECT_EQ(dfa.Next(dfa.GetStart(), 'b'), dfa.GetSink());
+}
+
+TEST(NKA_to_CsrNFA, Сorrectness) {
+  std::ifstream in("../tests/txt/NKA_without_eps/input1.txt",
+                   std::ifstream::in);  // (a + b)*c(a + c)*
+  Automaton automaton;
+  in >> automaton;
+  CsrNFA nfa(automaton);
+
+  EXPECT_EQ(nfa.GetVertexCount(), automaton.GetVertexCount());
+  EXPECT_EQ(nfa.GetEdgeCount(), 15);
+  EXPECT_EQ(nfa.GetStart(), 0);
+  EXPECT_TRUE(nfa.IsTerminal(3));
+  EXPECT_FALSE(nfa.IsTerminal(0));
+
+  for (size_t v = 0; v < nfa.GetVertexCount(); ++v) {
+    for (size_t e = nfa.EdgesBegin(v); e + 1 < nfa.EdgesEnd(v); ++e) {
+      EXPECT_LE(nfa.GetSymbol(e), nfa.GetSymbol(e + 1));
+    }
+  }
+  EXPECT_EQ(nfa.EdgesEnd(3) - nfa.EdgesBegin(3), 2);
+  EXPECT_EQ(nfa.GetSymbol(nfa.EdgesBegin(3)), 'a');
+  EXPECT_EQ(nfa.GetTarget(nfa.EdgesBegin(3)), 4);
+}
+
+TEST(Regex_to_NKA, SameAsOperators) {
+  Automaton a('a');
+  Automaton b('b');
+  Automaton c('c');
+  Automaton eps('1');
+
+  Automaton correct_automaton =
+      (*((a - b) + (b - a)) - c) - *(c + a);  // (ab + ba)*c(c + a)*
+  EXPECT_TRUE(Automaton(std::string("ab.ba.+*c.ca+*.")) == correct_automaton);
+
+  correct_automaton = *(*a + eps) - (b + *c);  // (a* + 1)*(b + c*)
+  EXPECT_TRUE(Automaton(std::string("a*1+*bc*+.")) == correct_automaton);
+}
+
+TEST(DenseDFA_Accepts, Сorrectness) {
+  Automaton automaton(std::string("ab.ba.+*c.ca+*."));  // (ab + ba)*c(c + a)*
+  automaton.ToMCDFA();
+  DenseDFA dfa(automaton);
+
+  EXPECT_TRUE(dfa.Accepts("c"));
+  EXPECT_TRUE(dfa.Accepts("abbacaac"));
+  EXPECT_TRUE(dfa.Accepts("bac"));
+  EXPECT_FALSE(dfa.Accepts(""));
+  EXPECT_FALSE(dfa.Accepts("aac"));
+  EXPECT_FALSE(dfa.Accepts("abcb"));
+  EXPECT_FALSE(dfa.Accepts("abxc"));
+
+  EXPECT_EQ(dfa.Run("abcb"), dfa.GetSink());
+  EXPECT_EQ(dfa.Run(dfa.Run("ab"), "c"), dfa.Run("abc"));
+
+  std::vector<std::string_view> words = {"c", "", "bacc", "bb", "abab"};
+  std::vector<bool> correct_result = {true, false, true, false, false};
+  EXPECT_EQ(dfa.Accepts(words), correct_result);
+}
+
+TEST(BatchRunner, Сorrectness) {
+  Automaton automaton(std::string("ab.ba.+*c.ca+*."));  // (ab + ba)*c(c + a)*
+  automaton.ToMCDFA();
+  DenseDFA dfa(automaton);
+
+  std::mt19937 gen(1);
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < 1000; ++i) {
+    std::string word = (gen() % 2 == 0 ? "ab" : "ba");
+    word += std::string(gen() % 3, 'c');
+    for (size_t j = gen() % (i % 10 == 0 ? 300 : 20); j > 0; --j) {
+      word += "acbx"[gen() % (i % 100 == 0 ? 4 : 2)];
+    }
+    strings.push_back(word);
+  }
+  strings.emplace_back();
+  strings.insert(strings.begin() + 10, 5, "");
+  std::vector<std::string_view> words(strings.begin(), strings.end());
+
+  std::vector<uint32_t> correct_states;
+  for (std::string_view word : words) {
+    correct_states.push_back(dfa.Run(word));
+  }
+  for (auto level :
+       {BatchRunner::SimdLevel::kScalar, BatchRunner::SimdLevel::kAvx2,
+        BatchRunner::SimdLevel::kAvx512}) {
+    if (!BatchRunner::IsSupported(level)) {
+      EXPECT_THROW(BatchRunner(dfa, level), std::runtime_error);
+      continue;
+    }
+    BatchRunner runner(dfa, level);
+    EXPECT_EQ(runner.Run(words), correct_states);
+    for (size_t size : {0, 1, 7, 17}) {
+      std::span<const std::string_view> prefix(words.data(), size);
+      EXPECT_EQ(runner.Run(prefix), std::vector<uint32_t>(
+                                        correct_states.begin(),
+                                        correct_states.begin() + size));
+    }
+  }
+}
+
+TEST(MultiPatternDFA, Сorrectness) {
+  std::vector<std::string> regexes = {"ab.ba.+*c.ca+*.", "ab+*a.ab+.ab+.",
+                                      "a*b*.c+*ab.*.",   "ab.1+*c1..a*+*",
+                                      "ab+*",            "ab.",
+                                      "ab.ba.+*c.ca+*."};
+  MultiPatternDFA multi_pattern_dfa(regexes);
+  EXPECT_EQ(multi_pattern_dfa.GetPatternCount(), regexes.size());
+
+  std::vector<DenseDFA> dfas;
+  for (const std::string& regex : regexes) {
+    Automaton automaton(regex);
+    automaton.ToMCDFA();
+    dfas.emplace_back(automaton);
+  }
+
+  std::mt19937 gen(1);
+  for (size_t i = 0; i < 1000; ++i) {
+    std::string word(gen() % 10, 'a');
+    for (char& symbol : word) {
+      symbol = "abcd"[gen() % 4];
+    }
+    std::vector<uint32_t> correct_ids;
+    for (uint32_t id = 0; id < dfas.size(); ++id) {
+      if (dfas[id].Accepts(word)) {
+        correct_ids.push_back(id);
+      }
+    }
+    EXPECT_EQ(multi_pattern_dfa.Match(word), correct_ids) << word;
+  }
+  EXPECT_EQ(multi_pattern_dfa.Run("abd"), multi_pattern_dfa.GetSink());
+
+  for (const std::string& regex : regexes) {
+    Automaton automaton(regex);
+    automaton.ToMCDFA();
+    EXPECT_EQ(MultiPatternDFA({regex}).GetStateCount(),
+              DenseDFA(automaton).GetStateCount())
+        << regex;
+  }
+}
+
+TEST(ParallelScanner, Сorrectness) {
+  std::mt19937 gen(1);
+  // (ab + ba)*c(c + a)*, (a + b)*a(a + b)(a + b), (aaa)*, (a^11 + b)*
+  std::vector<std::pair<std::string, std::string>> tests = {
+      {"ab.ba.+*c.ca+*.", "abc"},
+      {"ab+*a.ab+.ab+.", "ab"},
+      {"aa.a.*", "a"},
+      {"aa.a.a.a.a.a.a.a.a.a.b+*", "a"}};
+  for (const auto& [str, letters] : tests) {
+    Automaton automaton(str);
+    automaton.ToMCDFA();
+    auto dfa = std::make_shared<const DenseDFA>(automaton);
+
+    std::string input(1 << 20, 'a');
+    for (char& symbol : input) {
+      symbol = letters[gen() % letters.size()];
+    }
+
+    for (size_t threads_count : {1, 3, 8}) {
+      ParallelScanner scanner(dfa, threads_count);
+      EXPECT_EQ(scanner.Run(input), dfa->Run(input)) << str;
+      EXPECT_EQ(scanner.Run(input.substr(0, 1000)),
+                dfa->Run(input.substr(0, 1000)))
+          << str;
+    }
+
+    const std::string path =
+        std::filesystem::temp_directory_path() / "parallel_scanner_test.txt";
+    std::ofstream(path, std::ios::binary) << input;
+    EXPECT_EQ(ParallelScanner(dfa, 4).AcceptsFile(path), dfa->Accepts(input))
+        << str;
+    std::remove(path.c_str());
+  }
+}
+
+TEST(ParallelScanner, ManyStates) {
+  // (a^3000)*: no two walks ever merge, so every chunk is given up.
+  std::string str = "a";
+  for (size_t i = 1; i < 3000; ++i) {
+    str += "a.";
+  }
+  str += "*";
+  Automaton automaton(str);
+  automaton.ToMCDFA();
+  auto dfa = std::make_shared<const DenseDFA>(automaton);
+
+  const std::string input(size_t{1} << 23, 'a');
+  auto begin = std::chrono::steady_clock::now();
+  const uint32_t state = ParallelScanner(dfa, 1).Run(input);
+  const auto serial_time = std::chrono::steady_clock::now() - begin;
+  EXPECT_EQ(state, dfa->Run(input));
+  begin = std::chrono::steady_clock::now();
+  EXPECT_EQ(ParallelScanner(dfa, 4).Run(input), state);
+  // Giving up costs about a quarter more than a serial scan in optimized
+  // builds; probing 4096 bytes from all states took 15 times as long.
+  EXPECT_LT(std::chrono::steady_clock::now() - begin,
+            8 * serial_time + std::chrono::milliseconds(50));
+}
+
+TEST(Searcher, Сorrectness) {
+  Searcher searcher(std::string("ab.ba.+*c.ca+*."));  // (ab + ba)*c(c + a)*
+  std::vector<Searcher::Match> correct_matches = {{2, 7}, {8, 11}, {12, 13}};
+  EXPECT_EQ(searcher.FindAll("xxabcaaxbacbc"), correct_matches);
+  EXPECT_EQ(searcher.FindEnds("bcxc"), std::vector<size_t>({2, 4}));
+
+  std::mt19937 gen(1);
+  for (std::string str : {"ab.ba.+*c.ca+*.", "ab+*a.ab+.", "a*b.", "ab*+",
+                          "ab.ab.c.+"}) {
+    Searcher searcher(str);
+    Automaton automaton(str);
+    automaton.ToMCDFA();
+    DenseDFA dfa(automaton);
+
+    for (size_t i = 0; i < 50; ++i) {
+      std::string text(gen() % 30, 'a');
+      for (char& symbol : text) {
+        symbol = "abcx"[gen() % 4];
+      }
+
+      std::vector<size_t> correct_ends;
+      std::vector<bool> correct_starts(text.size() + 1);
+      std::vector<size_t> correct_longest_ends(text.size() + 1,
+                                               Searcher::kNoMatch);
+      for (size_t end = 0; end <= text.size(); ++end) {
+        for (size_t begin = 0; begin <= end; ++begin) {
+          if (dfa.Accepts(text.substr(begin, end - begin))) {
+            if (correct_ends.empty() || correct_ends.back() != end) {
+              correct_ends.push_back(end);
+            }
+            correct_starts[begin] = true;
+            correct_longest_ends[begin] = end;
+          }
+        }
+      }
+      EXPECT_EQ(searcher.FindEnds(text), correct_ends) << str << ' ' << text;
+      EXPECT_EQ(searcher.FindStarts(text), correct_starts)
+          << str << ' ' << text;
+      EXPECT_EQ(searcher.FindLongestEnds(text), correct_longest_ends)
+          << str << ' ' << text;
+
+      std::vector<Searcher::Match> correct_matches;
+      for (size_t begin = 0; begin <= text.size();) {
+        size_t end = text.size();
+        while (end > begin && !dfa.Accepts(text.substr(begin, end - begin))) {
+          --end;
+        }
+        if (dfa.Accepts(text.substr(begin, end - begin))) {
+          correct_matches.push_back({begin, end});
+        }
+        begin = end > begin ? end : begin + 1;
+      }
+      EXPECT_EQ(searcher.FindAll(text), correct_matches) << str << ' ' << text;
+    }
+  }
+}
+
+TEST(Searcher, LongText) {
+  // Every a is a match, the walk from it reads all the following ones.
+  // a + (aa)*b makes the walks from neighbouring offsets alternate between
+  // two states, so they never merge.
+  for (std::string str : {"aa*b.+", "aaa.*b.+"}) {
+    Searcher searcher(str);
+    std::string text(1 << 20, 'a');
+    std::vector<Searcher::Match> correct_matches;
+    for (size_t i = 0; i < text.size(); ++i) {
+      correct_matches.push_back({i, i + 1});
+    }
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_EQ(searcher.FindAll(text), correct_matches) << str;
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(5))
+        << str;
+  }
+
+  Searcher searcher(std::string("aa*b.+"));  // a + a*b
+  std::string text(200000, 'a');
+  text.back() = 'b';
+  std::vector<Searcher::Match> correct_matches = {{0, text.size()}};
+  EXPECT_EQ(searcher.FindAll(text), correct_matches);
+}
+
+TEST(StreamMatcher, Сorrectness) {
+  Automaton automaton(std::string("ab.ba.+*c.ca+*."));  // (ab + ba)*c(c + a)*
+  automaton.ToMCDFA();
+  StreamMatcher matcher(automaton);
+
+  matcher.Feed("aba");
+  EXPECT_FALSE(matcher.Finish());
+  matcher.Feed("bc");
+  EXPECT_TRUE(matcher.Finish());
+  matcher.Feed(std::string(1000, 'a'));
+  EXPECT_TRUE(matcher.Finish());
+  EXPECT_FALSE(matcher.IsDead());
+
+  matcher.Feed("b");
+  EXPECT_TRUE(matcher.IsDead());
+  matcher.Feed(std::string(1000, 'c'));
+  EXPECT_FALSE(matcher.Finish());
+
+  matcher.Reset();
+  matcher.Feed("");
+  matcher.Feed("c");
+  EXPECT_TRUE(matcher.Finish());
+}
+
+TEST(BitParallelNFA, Сorrectness) {
+  std::mt19937 gen(1);
+  for (std::string str : {"ab.ba.+*c.ca+*.", "ab+*a.ab+.ab+.ab+.", "a**1+",
+                          "a*b*.c+*ab.*.", "ab.1+*c1..a*+*"}) {
+    Automaton automaton(str);
+    automaton.ToMCDFA();
+    DenseDFA dfa(automaton);
+
+    BitParallelNFA thompson((Automaton(str)));
+    BitParallelNFA glushkov(Automaton(str, RegexConstruction::kGlushkov));
+    EXPECT_TRUE(glushkov.IsHomogeneous()) << str;
+
+    for (size_t i = 0; i < 300; ++i) {
+      std::string word(gen() % 10, 'a');
+      for (char& symbol : word) {
+        symbol = "abcd"[gen() % 4];
+      }
+      EXPECT_EQ(thompson.Accepts(word), dfa.Accepts(word)) << str << word;
+      EXPECT_EQ(glushkov.Accepts(word), dfa.Accepts(word)) << str << word;
+    }
+  }
+
+  std::string long_concatenation = "a";
+  for (size_t i = 0; i < 64; ++i) {
+    long_concatenation += "b.";
+  }
+  EXPECT_THROW(BitParallelNFA(Automaton(long_concatenation)),
+               std::runtime_error);
+}
+
+TEST(AdaptiveMatcher, Сorrectness) {
+  // (a + b)*a(a + b)^n, the DFA has 2^(n + 1) states
+  std::string str = "ab+*a.";
+  for (size_t i = 0; i < 14; ++i) {
+    str += "ab+.";
+  }
+  AdaptiveMatcher matcher((Automaton(str)));
+  EXPECT_EQ(matcher.GetEngine(), AdaptiveMatcher::Engine::kBitParallelNFA);
+  EXPECT_TRUE(matcher.Accepts("ba" + std::string(14, 'b')));
+  EXPECT_FALSE(matcher.Accepts("ab" + std::string(14, 'b')));
+
+  AdaptiveMatcher small((Automaton(std::string("ab.ba.+*c.ca+*."))));
+  EXPECT_EQ(small.GetEngine(), AdaptiveMatcher::Engine::kDenseDFA);
+  EXPECT_TRUE(small.Accepts("abbacaac"));
+  EXPECT_FALSE(small.Accepts("abcb"));
+
+  for (size_t i = 0; i < 60; ++i) {
+    str += "ab+.";
+  }
+  AdaptiveMatcher large((Automaton(str)));
+  EXPECT_EQ(large.GetEngine(), AdaptiveMatcher::Engine::kLazyDFA);
+  EXPECT_TRUE(large.Accepts("a" + std::string(74, 'b')));
+  EXPECT_FALSE(large.Accepts("a" + std::string(75, 'b')));
+
+  Automaton only_eps(std::string("1"));
+  AdaptiveMatcher eps_matcher(only_eps);
+  only_eps.ToMCDFA();
+  DenseDFA eps_dfa(only_eps);
+  EXPECT_EQ(eps_matcher.GetEngine(), AdaptiveMatcher::Engine::kDenseDFA);
+  EXPECT_EQ(eps_matcher.Accepts(""), eps_dfa.Accepts(""));
+  EXPECT_FALSE(eps_matcher.Accepts("a"));
+
+  std::istringstream in("0\n\n\n0 1 a\n1 0 b\n");  // no terminal vertexes
+  Automaton empty;
+  in >> empty;
+  AdaptiveMatcher empty_matcher(empty);
+  EXPECT_EQ(empty_matcher.GetEngine(), AdaptiveMatcher::Engine::kDenseDFA);
+  EXPECT_FALSE(empty_matcher.Accepts(""));
+  EXPECT_FALSE(empty_matcher.Accepts("ab"));
+}
+
+TEST(LazyDFA, Сorrectness) {
+  std::string str = "ab+*a.";  // (a + b)*a(a + b)^n
+  for (size_t i = 0; i < 6; ++i) {
+    str += "ab+.";
+  }
+  Automaton automaton(str);
+  LazyDFA lazy_dfa(automaton, 8);
+  automaton.ToMCDFA();
+  DenseDFA dfa(automaton);
+
+  std::mt19937 gen(1);
+  for (size_t i = 0; i < 1000; ++i) {
+    std::string word(gen() % 20, 'a');
+    for (char& symbol : word) {
+      symbol = "abc"[gen() % 3];
+    }
+    EXPECT_EQ(lazy_dfa.Accepts(word), dfa.Accepts(word)) << word;
+  }
+  EXPECT_LE(lazy_dfa.GetCachedStateCount(), 8);
+  EXPECT_GT(lazy_dfa.GetFlushCount(), 0);
+}
+
+TEST(LazyDFA, ExponentialBlowUp) {
+  std::string str = "ab+*a.";  // (a + b)*a(a + b)^20
+  for (size_t i = 0; i < 20; ++i) {
+    str += "ab+.";
+  }
+  LazyDFA lazy_dfa((Automaton(str)));
+
+  std::mt19937 gen(2);
+  for (size_t i = 0; i < 100; ++i) {
+    std::string word(21 + gen() % 100, 'a');
+    for (char& symbol : word) {
+      symbol = "ab"[gen() % 2];
+    }
+    EXPECT_EQ(lazy_dfa.Accepts(word), word[word.size() - 21] == 'a');
+  }
+  EXPECT_LE(lazy_dfa.GetCachedStateCount(), LazyDFA::kDefaultMaxStates);
+}
+
+TEST(SuffixQuery, Сorrectness) {
+  // (ab + ba)*c(c + a)*, a^5(b + aaa)*, (a + b)*a(a + b)^4
+  for (std::string str : {"ab.ba.+*c.ca+*.", "aa.a.a.a.baa.a.+*.",
+                          "ab+*a.ab+.ab+.ab+.ab+."}) {
+    Automaton automaton(str);
+    SuffixQuery query(automaton);
+    automaton.ToMCDFA();
+    DenseDFA dfa(automaton);
+
+    std::vector<size_t> lengths(40);
+    for (size_t i = 0; i < lengths.size(); ++i) {
+      lengths[i] = i;
+    }
+    for (char symbol : std::string("abcd")) {
+      std::vector<bool> batch =
+          query.IsSuffixByLetterFixLength(symbol, lengths);
+      for (size_t length : lengths) {
+        bool expected = false;
+        if (dfa.GetAlphabet().find(symbol) != std::string::npos) {
+          std::string word(length, symbol);
+          for (uint32_t v = 0; v < dfa.GetStateCount(); ++v) {
+            expected |= dfa.IsTerminal(dfa.Run(v, word));
+          }
+        }
+        EXPECT_EQ(query.IsSuffixByLetterFixLength(symbol, length), expected)
+            << str << ' ' << symbol << ' ' << length;
+        EXPECT_EQ(batch[length], expected);
+      }
+    }
+  }
+}
+
+TEST(CompiledAutomaton, SharedBetweenThreads) {
+  // (ab + ba)*c(c + a)*
+  const CompiledAutomaton compiled(std::string("ab.ba.+*c.ca+*."));
+
+  std::vector<std::string> words(1000);
+  std::mt19937 gen(1);
+  for (std::string& word : words) {
+    word.resize(gen() % 12);
+    for (char& symbol : word) {
+      symbol = "abc"[gen() % 3];
+    }
+  }
+  std::vector<bool> expected(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    expected[i] = compiled.Accepts(words[i]);
+  }
+
+  std::vector<size_t> mismatches(4, 0);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < mismatches.size(); ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t round = 0; round < 50; ++round) {
+        for (size_t i = 0; i < words.size(); ++i) {
+          mismatches[t] += compiled.Accepts(words[i]) != expected[i];
+        }
+        mismatches[t] += !compiled.IsSuffixByLetterFixLength('c', round);
+        mismatches[t] += compiled.IsSuffixByLetterFixLength('b', round + 2);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(mismatches, std::vector<size_t>(4, 0));
+}
+
+TEST(RegexCache, Сorrectness) {
+  RegexCache cache(RegexCache::kShardsCount);
+  auto first = cache.Get("ab.ba.+*c.ca+*.");
+  auto second = cache.Get("ab.ba.+*c.ca+*.");
+  EXPECT_EQ(first, second);
+  EXPECT_TRUE(first->Accepts("abbac"));
+  EXPECT_EQ(cache.GetHitCount(), 1);
+  EXPECT_EQ(cache.GetMissCount(), 1);
+
+  EXPECT_THROW(cache.Get("ab"), std::runtime_error);
+  EXPECT_EQ(cache.GetSize(), 1);
+
+  std::string str = "a";  // a, a^2, ..., a^100
+  for (size_t i = 0; i < 100; ++i) {
+    cache.Get(str);
+    str += "a.";
+  }
+  EXPECT_LE(cache.GetSize(), RegexCache::kShardsCount);
+  // The incorrect regex is counted as a miss too.
+  EXPECT_EQ(cache.GetMissCount() - cache.GetEvictionCount() - 1,
+            cache.GetSize());
+
+  cache.Clear();
+  EXPECT_EQ(cache.GetSize(), 0);
+}
+
+TEST(DenseDFA_Binary, Сorrectness) {
+  Automaton automaton(std::string("ab.ba.+*c.ca+*."));  // (ab + ba)*c(c + a)*
+  automaton.ToMCDFA();
+  DenseDFA dfa(automaton);
+
+  std::stringstream stream;
+  dfa.Save(stream);
+  const std::string data = stream.str();
+  DenseDFA loaded = DenseDFA::Load(stream);
+  EXPECT_EQ(loaded.GetAlphabet(), dfa.GetAlphabet());
+  EXPECT_EQ(loaded.GetTable(), dfa.GetTable());
+
+  const std::string path =
+      std::filesystem::temp_directory_path() / "dense_dfa_binary_test.dfa";
+  std::ofstream(path, std::ios::binary) << data;
+  MappedDFA mapped(path);
+  EXPECT_EQ(mapped.GetStateCount(), dfa.GetStateCount());
+  EXPECT_EQ(mapped.GetSink(), dfa.GetSink());
+
+  std::mt19937 gen(1);
+  for (size_t i = 0; i < 1000; ++i) {
+    std::string word(gen() % 12, 'a');
+    for (char& symbol : word) {
+      symbol = "abcd"[gen() % 4];
+    }
+    EXPECT_EQ(loaded.Accepts(word), dfa.Accepts(word)) << word;
+    EXPECT_EQ(mapped.Accepts(word), dfa.Accepts(word)) << word;
+  }
+
+  std::string broken = data;
+  broken.back() ^= 1;
+  std::ofstream(path, std::ios::binary) << broken;
+  EXPECT_THROW(MappedDFA{path}, std::runtime_error);
+  std::stringstream broken_stream(broken);
+  EXPECT_THROW(DenseDFA::Load(broken_stream), std::runtime_error);
+  std::stringstream truncated(data.substr(0, data.size() - 4));
+  EXPECT_THROW(DenseDFA::Load(truncated), std::runtime_error);
+  std::string huge = data;
+  const uint32_t states_count = UINT32_MAX;
+  std::memcpy(huge.data() + offsetof(DFAFileHeader, states_count),
+              &states_count, sizeof(states_count));
+  std::stringstream huge_stream(huge);
+  EXPECT_THROW(DenseDFA::Load(huge_stream), std::runtime_error);
+
+  // A broken target and a sink with an outgoing edge, both with a matching
+  // checksum, are rejected even without the full check.
+  DFAFileHeader header{};
+  std::memcpy(&header, data.data(), sizeof(header));
+  const DFAFileLayout layout = GetDFAFileLayout(header);
+  const size_t sink_offset = layout.table_offset +
+                             size_t{header.sink} * header.columns_count * 4;
+  const uint32_t start = header.start;
+  for (auto [offset, target] :
+       {std::pair{layout.table_offset, header.states_count},
+        std::pair{sink_offset, start}}) {
+    std::string corrupt = data;
+    std::memcpy(corrupt.data() + offset, &target, sizeof(target));
+    const uint64_t checksum = GetDFAFileChecksum(
+        corrupt.data() + sizeof(header), corrupt.size() - sizeof(header));
+    std::memcpy(corrupt.data() + offsetof(DFAFileHeader, checksum), &checksum,
+                sizeof(checksum));
+    std::ofstream(path, std::ios::binary) << corrupt;
+    EXPECT_THROW(MappedDFA(path, false), std::runtime_error);
+    EXPECT_THROW(MappedDFA{path}, std::runtime_error);
+    std::stringstream corrupt_stream(corrupt);
+    EXPECT_THROW(DenseDFA::Load(corrupt_stream), std::runtime_error);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(AutomatonParser, SameAsOperator) {
+  for (std::string path :
+       {"../tests/txt/NKA/input1.txt", "../tests/txt/NKA/input2.txt",
+        "../tests/txt/DKA/input1.txt", "../tests/txt/MPDKA/input2.txt",
+        "../tests/txt/PDKA/input3.txt"}) {
+    Automaton expected;
+    std::ifstream in(path, std::ios_base::in);
+    in >> expected;
+    EXPECT_TRUE(AutomatonParser::ParseFile(path) == expected) << path;
+  }
+
+  Automaton automaton(std::string("ab.ba.+*c.ca+*."));
+  std::stringstream stream;
+  stream << automaton;
+  Automaton expected;
+  stream >> expected;
+  EXPECT_TRUE(AutomatonParser::Parse(stream.str()) == expected);
+
+  EXPECT_THROW(AutomatonParser::Parse("0\n\n1\n\n0 x a\n"),
+               std::runtime_error);
+  EXPECT_THROW(AutomatonParser::Parse(""), std::runtime_error);
+  EXPECT_THROW(AutomatonParser::Parse("0\n\n1\n\n0 18446744073709551617 a\n"),
+               std::runtime_error);  // 2^64 + 1
+  EXPECT_THROW(AutomatonParser::Parse("0\n\n1\n\n0 18446744073709551615 a\n"),
+               std::runtime_error);  // 2^64 - 1
+  EXPECT_THROW(AutomatonParser::Parse(
+                   "0\n\n" + std::to_string(AutomatonParser::kMaxVertexCount) +
+                   "\n\n0 1 a\n"),
+               std::runtime_error);
+}
+
+TEST(PipelineStats, Сorrectness) {
+  PipelineStats stats;
+  Automaton automaton(std::string("ab+*a.ab+.ab+."), &stats);
+  automaton.ToMCDFA();
+
+  std::vector<std::string> names;
+  for (const StageStats& stage : stats.stages) {
+    names.push_back(stage.name);
+  }
+  std::vector<std::string> correct_names = {
+      "Construct", "RemoveReachLessVertex", "RemoveEpsEdges", "ToDFA",
+      "ToCDFA",    "ToMCDFA"};
+  EXPECT_EQ(names, correct_names);
+  EXPECT_EQ(stats.stages.back().vertexes_count, 8);
+  EXPECT_EQ(stats.stages.back().edges_count, 16);
+  EXPECT_GT(stats.stages.back().bytes, 0);
+  EXPECT_GE(stats.subsets_count, 8);
+  EXPECT_GT(stats.refinement_rounds, 0);
+  EXPECT_EQ(stats.ToJson().find("{\"stages\": [{\"name\": \"Construct\""),
+            0);
+
+  Automaton other(std::string("ab+*a.ab+.ab+."));
+  other.ToMCDFA();
+  EXPECT_TRUE(other == automaton);
+  EXPECT_EQ(stats.stages.size(), 6);
+}
+
+TEST(Regex_to_DKA, Parallel) {
+  for (std::string str : {"ab.ba.+*c.ca+*.", "ab+*a.ab+.ab+.ab+.ab+.ab+.",
+                          "a*b*.c+*ab.*.", "1"}) {
+    Automaton automaton(str);
+    automaton.ToDFA();
+    for (size_t threads_count : {2, 4}) {
+      Automaton parallel(str);
+      parallel.ToDFA(threads_count);
+      EXPECT_TRUE(parallel == automaton) << str << ' ' << threads_count;
+    }
+  }
+}
+
+TEST(Regex_to_MPDKA, ParallelMoore) {
+  for (std::string str : {"ab.ba.+*c.ca+*.", "ab+*a.ab+.ab+.ab+.ab+.ab+.",
+                          "a*b*.c+*ab.*.", "ab.a.b.a.b.a.b.a.b.", "1"}) {
+    Automaton automaton(str);
+    automaton.ToMCDFA(MinimizationAlgorithm::kMoore);
+    for (size_t threads_count : {2, 3, 8}) {
+      Automaton parallel(str);
+      parallel.ToMCDFA(MinimizationAlgorithm::kMoore, threads_count);
+      EXPECT_TRUE(parallel == automaton) << str << ' ' << threads_count;
+    }
+  }
+
+  std::mt19937 gen(1);
+  std::vector<size_t> table(1000 * 3);
+  std::vector<size_t> initial_classes(1000);
+  for (size_t& to : table) {
+    to = gen() % 1000;
+  }
+  for (size_t& number : initial_classes) {
+    number = gen() % 3;
+  }
+  EXPECT_EQ(ParallelMooreClasses(table, 3, initial_classes, 4),
+            MooreClasses(table, 3, initial_classes));
+}
+
+TEST(Regex_to_NKA, Glushkov) {
+  // (ab + ba)*c(c + a)*
+  Automaton nka(std::string("ab.ba.+*c.ca+*."), RegexConstruction::kGlushkov);
+  EXPECT_EQ(nka.GetVertexCount(), 8);
+
+  for (std::string str : {"ab.ba.+*c.ca+*.", "ab+*a.ab+.ab+.ab+.", "a**1+",
+                          "1", "a*b*.c+*ab.*.", "ab.1+*c1..a*+*"}) {
+    Automaton thompson(str);
+    Automaton glushkov(str, RegexConstruction::kGlushkov);
+    thompson.ToMCDFA();
+    glushkov.ToMCDFA();
+    EXPECT_TRUE(glushkov == thompson) << str;
+  }
+  EXPECT_THROW(Automaton("a+", RegexConstruction::kGlushkov),
+               std::runtime_error);
+}
+
+TEST(DerivativeDFA, Сorrectness) {
+  std::mt19937 gen(1);
+  for (std::string str : {"ab.ba.+*c.ca+*.", "ab+*a.ab+.ab+.ab+.", "a**1+",
+                          "a*b*.c+*ab.*.", "ab.1+*c1..a*+*"}) {
+    DerivativeDFA derivative_dfa(str);
+    Automaton automaton(str);
+    automaton.ToMCDFA();
+    DenseDFA dfa(automaton);
+
+    for (size_t i = 0; i < 300; ++i) {
+      std::string word(gen() % 10, 'a');
+      for (char& symbol : word) {
+        symbol = "abcd"[gen() % 4];
+      }
+      EXPECT_EQ(derivative_dfa.Accepts(word), dfa.Accepts(word))
+          << str << ' ' << word;
+    }
+
+    Automaton built = derivative_dfa.ToAutomaton();
+    built.ToMCDFA();
+    EXPECT_TRUE(built == automaton) << str;
+  }
+}
+
+TEST(DerivativeDFA, LongRegex) {
+  std::string concatenation = "a";  // (ab)^n a
+  std::string word = "a";
+  for (size_t i = 0; i < 20000; ++i) {
+    concatenation += "b.a.";
+    word += "ba";
+  }
+  DerivativeDFA long_dfa(concatenation);
+  EXPECT_TRUE(long_dfa.Accepts(word));
+  EXPECT_FALSE(long_dfa.Accepts(word + "b"));
+
+  std::string nested = "a";  // (((a + b)c + b)c + ...)c
+  for (size_t i = 0; i < 20000; ++i) {
+    nested += "b+c.";
+  }
+  DerivativeDFA deep_dfa(nested);
+  EXPECT_TRUE(deep_dfa.Accepts("bccc"));
+  EXPECT_FALSE(deep_dfa.Accepts("a"));
+}